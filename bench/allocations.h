@@ -0,0 +1,45 @@
+#pragma once
+
+// counts heap allocations of a benchmark or test, include it in a single
+// translation unit: it replaces the global operator new and delete
+
+#include <atomic>
+#include <cstdlib>
+#include <new>
+
+inline std::atomic<long> allocations{0};
+
+// out of line, or gcc warns about free() on inlined new expressions
+__attribute__((noinline)) void *operator new(std::size_t size) {
+  allocations++;
+  if (void *p = std::malloc(size ? size : 1)) {
+    return p;
+  }
+  throw std::bad_alloc();
+}
+
+// std::pmr::new_delete_resource uses the aligned forms
+__attribute__((noinline)) void *operator new(std::size_t size,
+                                             std::align_val_t alignment) {
+  allocations++;
+  const auto align = static_cast<std::size_t>(alignment);
+  if (void *p = std::aligned_alloc(align, (size + align - 1) / align * align)) {
+    return p;
+  }
+  throw std::bad_alloc();
+}
+
+__attribute__((noinline)) void operator delete(void *p) noexcept {
+  std::free(p);
+}
+__attribute__((noinline)) void operator delete(void *p, std::size_t) noexcept {
+  std::free(p);
+}
+__attribute__((noinline)) void operator delete(void *p,
+                                               std::align_val_t) noexcept {
+  std::free(p);
+}
+__attribute__((noinline)) void
+operator delete(void *p, std::size_t, std::align_val_t) noexcept {
+  std::free(p);
+}
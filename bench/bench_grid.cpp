@@ -0,0 +1,193 @@
+// counts the mines around each cell of a 4096x4096 grid with
+// Grid::forEachNeighbor and its stencils, against the previous neighbor
+// iteration: a std::vector of positions per cell and a std::function call
+// per neighbor, then with the box sum stencil of neighborSums on a byte plane
+// the last passes compare the column major and tiled layouts of Grid, on one
+// thread and on a thread pool, with per cell lookups and with the tile walk of
+// forEachWithNeighbors
+//
+// usage: bench_grid [size] [mine percent]
+
+#include "allocations.h"
+#include "p5/boxsum.h"
+#include "p5/grid.h"
+
+#include <chrono>
+#include <cstdint>
+#include <cstdlib>
+#include <functional>
+#include <iostream>
+#include <random>
+#include <string>
+#include <vector>
+
+namespace {
+
+using Clock = std::chrono::steady_clock;
+
+struct Cell {
+  Position position;
+  bool mine{false};
+  std::uint8_t count{0};
+  explicit Cell(Position position_p) : position(position_p) {}
+};
+
+// the previous Position::Neighbors, without its 8 extra {0, 0} entries
+std::vector<Position> vectorNeighbors(Position pos) {
+  std::vector<Position> ret;
+  for (int col = -1; col <= 1; col++) {
+    for (int r = -1; r <= 1; r++) {
+      Position neighbor{pos.column + col, pos.row + r};
+      if (neighbor != pos) {
+        ret.push_back(neighbor);
+      }
+    }
+  }
+  return ret;
+}
+
+// the previous Grid::forEachNeighbor
+void functionForEachNeighbor(Grid<Cell> &grid, const Cell &cell,
+                             std::function<void(Cell &)> cb) {
+  for (auto neighbor : vectorNeighbors(cell.position)) {
+    if (neighbor.valid(grid.size())) {
+      cb(grid.at(neighbor));
+    }
+  }
+}
+
+template <typename F>
+void measure(const char *name, Grid<Cell> &grid, F count) {
+  const long before = allocations;
+  const auto start = Clock::now();
+  long total = 0;
+  grid.forEach([&](Cell &cell) {
+    cell.count = static_cast<std::uint8_t>(count(cell));
+    total += cell.count;
+  });
+  const std::chrono::duration<double, std::milli> elapsed =
+      Clock::now() - start;
+  const auto cells = double(grid.size().row) * grid.size().column;
+  std::cout << name << ": " << elapsed.count() << " ms, "
+            << elapsed.count() * 1e6 / cells << " ns per cell, "
+            << double(allocations - before) / cells
+            << " allocations per cell (total " << total << ")\n";
+}
+
+// neighbor counting over the whole grid, serial then on the pool
+template <typename Layout>
+void measureLayout(const char *name, Size size, int percent,
+                   ThreadPool &pool) {
+  Grid<Cell, Layout> grid(size);
+  grid.forEach([percent](Cell &cell) {
+    const auto h = (cell.position.column * 73856093u) ^
+                   (cell.position.row * 19349663u);
+    cell.mine = h % 100 < static_cast<unsigned>(percent);
+  });
+
+  auto count = [&grid](Cell &cell) {
+    int n = 0;
+    grid.forEachNeighbor(cell, [&n](const Cell &neighbor) {
+      n += neighbor.mine;
+    });
+    cell.count = static_cast<std::uint8_t>(n);
+  };
+
+  auto report = [&grid](const std::string &pass, std::size_t threads,
+                       std::chrono::duration<double, std::milli> elapsed) {
+    long total = 0;
+    grid.forEach([&total](const Cell &cell) { total += cell.count; });
+    std::cout << pass << ", " << threads << " thread(s): " << elapsed.count()
+              << " ms (total " << total << ")\n";
+  };
+
+  for (ThreadPool *p : {static_cast<ThreadPool *>(nullptr), &pool}) {
+    const auto start = Clock::now();
+    if (p) {
+      grid.forEach(count, *p);
+    } else {
+      grid.forEach(count);
+    }
+    report(std::string(name) + ", per cell lookups", p ? pool.size() : 1,
+           Clock::now() - start);
+  }
+
+  // neighbors at fixed offsets inside each tile
+  auto walk = [](Cell &cell, auto &&neighbors) {
+    int n = 0;
+    neighbors([&n](const Cell &neighbor) { n += neighbor.mine; });
+    cell.count = static_cast<std::uint8_t>(n);
+  };
+  for (ThreadPool *p : {static_cast<ThreadPool *>(nullptr), &pool}) {
+    const auto start = Clock::now();
+    grid.forEachWithNeighbors(walk, p);
+    report(std::string(name) + ", tile walk", p ? pool.size() : 1,
+           Clock::now() - start);
+  }
+}
+
+} // namespace
+
+int main(int argc, char **argv) {
+  const int size = argc > 1 ? std::atoi(argv[1]) : 4096;
+  const int percent = argc > 2 ? std::atoi(argv[2]) : 15;
+
+  Grid<Cell> grid(Size{size, size});
+  std::mt19937 gen(42);
+  std::uniform_int_distribution<> chance(0, 99);
+  grid.forEach([&](Cell &cell) { cell.mine = chance(gen) < percent; });
+
+  measure("std::vector + std::function", grid, [&grid](const Cell &cell) {
+    int count = 0;
+    functionForEachNeighbor(grid, cell, [&count](Cell &neighbor) {
+      count += neighbor.mine;
+    });
+    return count;
+  });
+
+  measure("stencil, 8 neighbors        ", grid, [&grid](const Cell &cell) {
+    int count = 0;
+    grid.forEachNeighbor(
+        cell, [&count](const Cell &neighbor) { count += neighbor.mine; });
+    return count;
+  });
+
+  measure("stencil, 4 neighbors        ", grid, [&grid](const Cell &cell) {
+    int count = 0;
+    grid.forEachNeighbor<FourNeighbors>(
+        cell, [&count](const Cell &neighbor) { count += neighbor.mine; });
+    return count;
+  });
+
+  measure("stencil, radius 2           ", grid, [&grid](const Cell &cell) {
+    int count = 0;
+    grid.forEachNeighbor<Stencil<2, true>>(
+        cell, [&count](const Cell &neighbor) { count += neighbor.mine; });
+    return count;
+  });
+
+  std::vector<std::uint8_t> mines;
+  mines.reserve(grid.size().row * std::size_t(grid.size().column));
+  grid.forEach([&mines](const Cell &cell) { mines.push_back(cell.mine); });
+  std::vector<std::uint8_t> counts(mines.size());
+
+  ThreadPool pool;
+  for (ThreadPool *p : {static_cast<ThreadPool *>(nullptr), &pool}) {
+    const auto start = Clock::now();
+    neighborSums(grid.size(), mines.data(), counts.data(), p);
+    const std::chrono::duration<double, std::milli> elapsed =
+        Clock::now() - start;
+    long total = 0;
+    for (auto count : counts) {
+      total += count;
+    }
+    std::cout << "box sum, " << (p ? pool.size() : 1) << " thread(s): "
+              << elapsed.count() << " ms, "
+              << elapsed.count() * 1e6 / mines.size() << " ns per cell (total "
+              << total << ")\n";
+  }
+
+  measureLayout<ColumnMajor>("column major layout", grid.size(), percent,
+                             pool);
+  measureLayout<Tiled<64>>("64x64 tiled layout", grid.size(), percent, pool);
+}
@@ -0,0 +1,91 @@
+// compares loading saved brains with NeuralNetwork::Load, which builds a json
+// document then the matrices, and NeuralNetwork::load, which streams the
+// weights into an existing network, on indented and compact files
+//
+// usage: bench_json [brains] [directory]
+
+#include "allocations.h"
+#include "neuralnetwork/nn.h"
+
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <iostream>
+#include <string>
+#include <vector>
+
+namespace {
+
+using Clock = std::chrono::steady_clock;
+
+constexpr int Inputs = 5;
+constexpr int Hiddens = 8;
+constexpr int Outputs = 2;
+
+std::uintmax_t fileSize(const std::string &path) {
+  std::FILE *f = std::fopen(path.c_str(), "rb");
+  if (!f) {
+    return 0;
+  }
+  std::fseek(f, 0, SEEK_END);
+  const long size = std::ftell(f);
+  std::fclose(f);
+  return static_cast<std::uintmax_t>(size);
+}
+
+template <typename F>
+void measure(const char *name, const std::vector<std::string> &paths, F load) {
+  const long before = allocations;
+  const auto start = Clock::now();
+  std::uint64_t checksum = 0;
+  for (const auto &path : paths) {
+    checksum ^= load(path);
+  }
+  const std::chrono::duration<double, std::micro> elapsed =
+      Clock::now() - start;
+  const double n = static_cast<double>(paths.size());
+  std::cout << "  " << name << ": " << elapsed.count() / n << " us, "
+            << double(allocations - before) / n
+            << " allocations per brain (checksum " << checksum << ")\n";
+}
+
+} // namespace
+
+int main(int argc, char **argv) {
+  const int brains = argc > 1 ? std::atoi(argv[1]) : 10000;
+  const std::string directory = argc > 2 ? argv[2] : "bench_json_brains";
+
+  if (std::system(("mkdir -p '" + directory + "'").c_str()) != 0) {
+    std::cerr << "can not create " << directory << '\n';
+    return 1;
+  }
+
+  for (bool compact : {false, true}) {
+    std::vector<std::string> paths;
+    std::uintmax_t bytes = 0;
+    for (int b = 0; b < brains; b++) {
+      paths.push_back(directory + "/brain_" + std::to_string(b) +
+                      (compact ? ".min.json" : ".json"));
+      NeuralNetwork(Inputs, Hiddens, Outputs).save(paths.back(), compact);
+      bytes += fileSize(paths.back());
+    }
+
+    std::cout << brains << (compact ? " compact" : " indented") << " brains, "
+              << bytes / brains << " bytes per file\n";
+
+    measure("Load (json document)", paths, [](const std::string &path) {
+      return NeuralNetwork::Load(path).hash();
+    });
+
+    NeuralNetwork nn(Inputs, Hiddens, Outputs);
+    measure("load (streaming)", paths, [&nn](const std::string &path) {
+      nn.load(path);
+      return nn.hash();
+    });
+
+    for (const auto &path : paths) {
+      std::remove(path.c_str());
+    }
+  }
+}
@@ -0,0 +1,148 @@
+// compares NeuralNetwork::train and predict, written with lazy matrix
+// expressions, with the same computations written with eager Matrix
+// operations (one temporary per operation)
+//
+// usage: bench_matrix [iterations]
+
+#include "allocations.h"
+#include "neuralnetwork/nn.h"
+
+#include <chrono>
+#include <cstdlib>
+#include <iostream>
+#include <string>
+
+namespace {
+
+// the eager version of NeuralNetwork, before expressions
+struct EagerNetwork {
+  Matrix weights_ih;
+  Matrix weights_ho;
+  Matrix bias_h;
+  Matrix bias_o;
+  double learning_rate{0.1};
+  ActivationFunction activation_function{NeuralNetwork::sigmoid};
+
+  explicit EagerNetwork(const NeuralNetwork &nn)
+      : weights_ih{nn.hiddenNodes(), nn.inputNodes()},
+        weights_ho{nn.outputNodes(), nn.hiddenNodes()},
+        bias_h{nn.hiddenNodes(), 1}, bias_o{nn.outputNodes(), 1} {
+    auto params = nn.parameters();
+    auto it = params.begin();
+    for (auto m : {&weights_ih, &weights_ho, &bias_h, &bias_o}) {
+      m->forEach([&it](double &val) { val = *it++; });
+    }
+  }
+
+  std::vector<double> parameters() const {
+    std::vector<double> params;
+    for (auto m : {&weights_ih, &weights_ho, &bias_h, &bias_o}) {
+      m->forEach([&params](double val) { params.push_back(val); });
+    }
+    return params;
+  }
+
+  std::vector<double> predict(const std::vector<double> &input_array) const {
+    auto inputs = Matrix::fromArray(input_array);
+    auto hidden = Matrix::multiply(weights_ih, inputs);
+    hidden.add(this->bias_h);
+    hidden.map(this->activation_function.func);
+
+    auto output = Matrix::multiply(this->weights_ho, hidden);
+    output.add(this->bias_o);
+    output.map(this->activation_function.func);
+    return output.toArray();
+  }
+
+  void train(const std::vector<double> &input_array,
+             const std::vector<double> &target_array) {
+    auto inputs = Matrix::fromArray(input_array);
+    auto hidden = Matrix::multiply(this->weights_ih, inputs);
+    hidden.add(this->bias_h);
+    hidden.map(this->activation_function.func);
+
+    auto outputs = Matrix::multiply(this->weights_ho, hidden);
+    outputs.add(this->bias_o);
+    outputs.map(this->activation_function.func);
+
+    auto targets = Matrix::fromArray(target_array);
+    auto output_errors = Matrix::subtract(targets, outputs);
+
+    auto gradients = Matrix::map(outputs, this->activation_function.dfunc);
+    gradients.multiply(output_errors);
+    gradients.multiply(this->learning_rate);
+
+    auto hidden_T = Matrix::transpose(hidden);
+    auto weight_ho_deltas = Matrix::multiply(gradients, hidden_T);
+    this->weights_ho.add(weight_ho_deltas);
+    this->bias_o.add(gradients);
+
+    auto who_t = Matrix::transpose(this->weights_ho);
+    auto hidden_errors = Matrix::multiply(who_t, output_errors);
+
+    auto hidden_gradient = Matrix::map(hidden, this->activation_function.dfunc);
+    hidden_gradient.multiply(hidden_errors);
+    hidden_gradient.multiply(this->learning_rate);
+
+    auto inputs_T = Matrix::transpose(inputs);
+    auto weight_ih_deltas = Matrix::multiply(hidden_gradient, inputs_T);
+    this->weights_ih.add(weight_ih_deltas);
+    this->bias_h.add(hidden_gradient);
+  }
+};
+
+template <typename F> void measure(const std::string &name, int n, F f) {
+  const long before = allocations;
+  auto start = std::chrono::steady_clock::now();
+  for (int i = 0; i < n; i++) {
+    f(i);
+  }
+  const double seconds = std::chrono::duration<double>(
+                             std::chrono::steady_clock::now() - start)
+                             .count();
+  std::cout << name << ": " << 1e9 * seconds / n << " ns, "
+            << double(allocations - before) / n << " allocations per call\n";
+}
+
+} // namespace
+
+int main(int argc, char *argv[]) {
+  const int iterations = argc > 1 ? std::stoi(argv[1]) : 200000;
+
+  // the bird network
+  NeuralNetwork lazy(5, 8, 2);
+  EagerNetwork eager(lazy);
+
+  std::vector<std::vector<double>> inputs(64, std::vector<double>(5));
+  std::vector<std::vector<double>> targets(64, std::vector<double>(2));
+  std::mt19937 gen(1);
+  std::uniform_real_distribution<> value(0.0, 1.0);
+  for (auto &input : inputs) {
+    for (auto &v : input) {
+      v = value(gen);
+    }
+  }
+  for (auto &target : targets) {
+    for (auto &v : target) {
+      v = value(gen);
+    }
+  }
+
+  double sink = 0;
+  measure("eager predict", iterations, [&](int i) {
+    sink += eager.predict(inputs[i % 64])[0];
+  });
+  measure("lazy predict ", iterations, [&](int i) {
+    sink += lazy.predict(inputs[i % 64])[0];
+  });
+  measure("eager train  ", iterations, [&](int i) {
+    eager.train(inputs[i % 64], targets[i % 64]);
+  });
+  measure("lazy train   ", iterations, [&](int i) {
+    lazy.train(inputs[i % 64], targets[i % 64]);
+  });
+
+  std::cout << "same weights after training: "
+            << (eager.parameters() == lazy.parameters() ? "yes" : "no")
+            << " (" << sink << ")\n";
+}
@@ -0,0 +1,177 @@
+// compares the genetic algorithm of flappy_bird with evolution strategies:
+// bird ticks simulated until a generation reaches a target score
+//
+// usage: bench_optimizers [target score] [max generations] [processes]
+//                         [verbose]
+// with processes > 0, rollouts run in worker processes instead of threads
+// rollouts consult an episode cache, verbose prints its hit rate per
+// generation
+
+#include "evaluation.h"
+#include "genetic.h"
+#include "neuralnetwork/es.h"
+#include "rollout.h"
+
+#include <chrono>
+#include <iostream>
+#include <string>
+
+namespace {
+
+using Evaluate = std::function<RolloutResult(
+    const std::vector<NeuralNetwork> &, const std::vector<std::uint32_t> &)>;
+
+struct Result {
+  int generations{0};
+  long ticks{0};
+  double best{0};
+  double seconds{0};
+  EpisodeCache::Stats cache;
+};
+
+// cache shared by the evaluations of one optimizer
+EpisodeCache cache{100000};
+bool verbose = false;
+
+void generationDone(Result &result, const RolloutResult &scores) {
+  result.ticks += scores.ticks;
+  result.generations++;
+  for (double score : scores.scores) {
+    result.best = std::max(result.best, score);
+  }
+
+  const auto &stats = cache.stats();
+  result.cache.hits += stats.hits;
+  result.cache.misses += stats.misses;
+  if (verbose) {
+    std::cout << "  generation " << result.generations << ": best "
+              << result.best << ", " << scores.ticks << " ticks, cache hits "
+              << stats.hits << "/" << stats.hits + stats.misses << '\n';
+  }
+  cache.resetStats();
+}
+
+struct Individual {
+  NeuralNetwork brain{5, 8, 2};
+  double score{0};
+  double fitness{0};
+};
+
+void print(const std::string &name, const Result &r, int target) {
+  std::cout << name << ": " << (r.best >= target ? "reached " : "missed ")
+            << target << " after " << r.generations << " generations, "
+            << r.ticks << " ticks, " << r.seconds << " s (best " << r.best
+            << ", cache hit rate " << 100 * r.cache.hitRate() << "%)\n";
+}
+
+// same as flappy_bird: every generation plays one shared course, children
+// are mutated copies of parents picked proportionally to their score
+Result geneticAlgorithm(int target, int max_generations,
+                        const Evaluate &evaluate) {
+  const int Population = 300;
+  std::mt19937 gen{1};
+  std::vector<Individual> population(Population);
+
+  Result result;
+  auto start = std::chrono::steady_clock::now();
+  while (result.generations < max_generations && result.best < target) {
+    std::vector<NeuralNetwork> brains;
+    for (const auto &individual : population) {
+      brains.push_back(individual.brain);
+    }
+    auto scores = evaluate(brains, {static_cast<std::uint32_t>(gen())});
+    generationDone(result, scores);
+
+    for (std::size_t i = 0; i < population.size(); i++) {
+      population[i].score = scores.scores[i];
+    }
+
+    genetic::calculateFitness(population);
+    genetic::Selection<std::vector<Individual>> selection(population);
+    std::vector<Individual> children(Population);
+    for (auto &child : children) {
+      child.brain = selection.pick(gen).brain;
+      child.brain.mutate(0.1);
+    }
+    population = std::move(children);
+  }
+  result.seconds = std::chrono::duration<double>(
+                       std::chrono::steady_clock::now() - start)
+                       .count();
+  return result;
+}
+
+// the antithetic pairs of a generation are evaluated on the same course, a
+// fresh one each generation; the mean itself is not evaluated, the best
+// candidate score is the generation score
+Result evolutionStrategy(int target, int max_generations,
+                         const Evaluate &evaluate) {
+  NeuralNetwork net{5, 8, 2};
+  EvolutionStrategy::Config es_config;
+  // decisions only flip for large perturbations of the random init
+  es_config.pairs = 50;
+  es_config.sigma = 2.0;
+  es_config.learning_rate = 0.1;
+  EvolutionStrategy es(net.parameters(), 1, es_config);
+  std::mt19937 gen{1};
+
+  Result result;
+  auto start = std::chrono::steady_clock::now();
+  while (result.generations < max_generations && result.best < target) {
+    auto candidates = es.ask();
+    std::vector<NeuralNetwork> brains(candidates.size(), net);
+    for (std::size_t i = 0; i < candidates.size(); i++) {
+      brains[i].setParameters(candidates[i]);
+    }
+    auto scores = evaluate(brains, {static_cast<std::uint32_t>(gen())});
+    generationDone(result, scores);
+    es.tell(scores.scores);
+  }
+  result.seconds = std::chrono::duration<double>(
+                       std::chrono::steady_clock::now() - start)
+                       .count();
+  return result;
+}
+
+} // namespace
+
+int main(int argc, char *argv[]) {
+  const int target = argc > 1 ? std::stoi(argv[1]) : 500;
+  const int max_generations = argc > 2 ? std::stoi(argv[2]) : 300;
+  const int processes = argc > 3 ? std::stoi(argv[3]) : 0;
+  verbose = argc > 4 && std::stoi(argv[4]) != 0;
+
+  VectorEnv::Config config;
+  config.max_score = target;
+
+  // workers are forked before any thread is started
+  std::unique_ptr<EvaluationWorkers> workers;
+  if (processes > 0) {
+    workers = std::make_unique<EvaluationWorkers>(processes);
+  }
+  ThreadPool pool;
+
+  Evaluate evaluate = [&](const std::vector<NeuralNetwork> &brains,
+                          const std::vector<std::uint32_t> &seeds) {
+    return cachedEvaluate(
+        brains, seeds, cache,
+        [&](const std::vector<NeuralNetwork> &played,
+            const std::vector<std::uint32_t> &played_seeds) {
+          return workers ? workers->evaluate(played, played_seeds, config)
+                         : rollout(played, played_seeds, config, pool);
+        });
+  };
+
+  std::cout << "target score " << target << ", ";
+  if (workers) {
+    std::cout << workers->size() << " processes\n";
+  } else {
+    std::cout << pool.size() << " threads\n";
+  }
+
+  print("genetic algorithm", geneticAlgorithm(target, max_generations, evaluate),
+        target);
+  cache.clear();
+  print("evolution strategy",
+        evolutionStrategy(target, max_generations, evaluate), target);
+}
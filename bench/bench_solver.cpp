@@ -0,0 +1,37 @@
+// plays seeded boards of the standard minesweeper levels with the headless
+// solver of solver.h, on a thread pool, and reports the boards played per
+// second and the win rate
+//
+// usage: bench_solver [boards] [threads]
+
+#include "solver.h"
+
+#include <cstdlib>
+#include <iomanip>
+#include <iostream>
+
+int main(int argc, char **argv) {
+  const std::size_t boards = argc > 1 ? std::atoi(argv[1]) : 10000;
+  ThreadPool pool(argc > 2 ? std::atoi(argv[2]) : ThreadPool::defaultSize());
+
+  struct Level {
+    const char *name;
+    Size size;
+    std::size_t mines;
+  };
+  const Level levels[] = {{"beginner     9x9   10", Size{9, 9}, 10},
+                          {"intermediate 16x16 40", Size{16, 16}, 40},
+                          {"expert       16x30 99", Size{16, 30}, 99}};
+
+  std::cout << boards << " boards per level, " << pool.size()
+            << " threads\n";
+  for (const auto &level : levels) {
+    const auto stats =
+        solver::playBoards(level.size, level.mines, boards, 1, &pool);
+    std::cout << level.name << ": " << std::fixed << std::setprecision(0)
+              << stats.boardsPerSecond() << " boards/s, win rate "
+              << std::setprecision(1) << 100 * stats.winRate() << "%, "
+              << std::setprecision(2) << double(stats.guesses) / stats.boards
+              << " guesses per board\n";
+  }
+}
@@ -1,27 +1,40 @@
 #pragma once
-#include "neuralnetwork/nn.h"
+#include "neuralnetwork/brain.h"
+#include "physics.h"
 #include "pipe.h"
 
+#include <algorithm>
+
 struct Bird {
 
   int x{20};
   int y;
-  int radius{10};
+  int radius{PhysicsRules{}.radius};
   int velocity{0};
-  int gravity{1};
-  int lift{-10};
-  NeuralNetwork brain{5, 8, 2};
+  int gravity{PhysicsRules{}.gravity};
+  int lift{PhysicsRules{}.lift};
+  Brain brain{arena()};
   int score{0};
   double fitness{0};
+  int id{0};               // index in the recorded episode
+  std::uint64_t parent{0}; // hash of the parent brain, 0 for a random brain
 
   Bird() = default;
   Bird(const Bird &) = default;
   Bird &operator=(const Bird &) = default;
   Bird(int x, int y) : x{x}, y{y} {}
 
+  /// all bird brains live in this arena, it is never destroyed so that
+  /// birds held by globals can still release their brain at exit
+  static BrainArena &arena() {
+    static auto *arena = new BrainArena(Topology{5, 8, 2});
+    return *arena;
+  }
+
   bool think(const Pipe &pipe, int width, int height) {
 
-    std::vector<double> input(5);
+    double input[5];
+    double output[2];
 
     input[0] = y / static_cast<double>(height);
     input[1] = pipe.x / static_cast<double>(width);
@@ -29,7 +42,7 @@ struct Bird {
     input[3] = (pipe.top + pipe.gate) / static_cast<double>(height);
     input[4] = velocity / 10.0;
 
-    auto output = brain.predict(input);
+    brain.predict(input, output);
 
     bool do_up = output[0] > output[1];
     if (do_up) {
@@ -49,11 +62,102 @@ struct Bird {
     return y < 0 || (y + radius > screen_height);
   }
 
+  bool hits(const Pipe &pipe) const {
+    return !(x > pipe.x + pipe.width || x + radius < pipe.x) &&
+           !(y > pipe.top && y + radius < pipe.top + pipe.gate);
+  }
+
   void up() { velocity = lift; }
 
-  static void draw(const Bird &bird, Canvas &canvas) {
+  template <typename Birds>
+  static void draw(const Birds &birds, Canvas &canvas) {
+    std::vector<Rect> rects;
+    rects.reserve(birds.size());
+    for (const Bird &bird : birds) {
+      rects.push_back({bird.x, bird.y, bird.radius, bird.radius});
+    }
+
     canvas.fill(80, 80, 80);
+    canvas.rects(rects);
+  }
 
-    canvas.rect(bird.x, bird.y, bird.radius, bird.radius);
+  ///
+  /// level of detail drawing for large populations:
+  /// birds are counted per pixel row and drawn as a heat strip,
+  /// only the top_k best scores are drawn as rects
+  ///
+  template <typename Birds>
+  static void drawDensity(const Birds &birds, Canvas &canvas,
+                          std::size_t top_k) {
+    if (birds.empty()) {
+      return;
+    }
+    const int height = canvas.height();
+
+    // per row difference array then prefix sum, O(birds + height)
+    std::vector<int> density(height + 1, 0);
+    int x_min = birds.front().x;
+    int x_max = birds.front().x + birds.front().radius;
+    for (const Bird &bird : birds) {
+      density[std::clamp(bird.y, 0, height)]++;
+      density[std::clamp(bird.y + bird.radius, 0, height)]--;
+      x_min = std::min(x_min, bird.x);
+      x_max = std::max(x_max, bird.x + bird.radius);
+    }
+    int max_density = 0;
+    for (int row = 0, sum = 0; row < height; row++) {
+      sum += density[row];
+      density[row] = sum;
+      max_density = std::max(max_density, sum);
+    }
+
+    // consecutive rows of the same heat level are merged in one rect
+    const int Levels = 8;
+    std::vector<Rect> strips[Levels];
+    auto level = [max_density](int count) {
+      return count == 0 ? -1 : (count * Levels - 1) / max_density;
+    };
+    for (int row = 0; row < height;) {
+      const int l = level(density[row]);
+      int end = row + 1;
+      while (end < height && level(density[end]) == l) {
+        end++;
+      }
+      if (l >= 0) {
+        strips[l].push_back({x_min, row, x_max - x_min, end - row});
+      }
+      row = end;
+    }
+
+    canvas.noStroke();
+    for (int l = 0; l < Levels; l++) {
+      if (!strips[l].empty()) {
+        const int heat = 220 - 220 * l / (Levels - 1);
+        canvas.fill(255, heat, heat / 2);
+        canvas.rects(strips[l]);
+      }
+    }
+    canvas.stroke(0, 0, 0);
+
+    // best birds on top of the strip
+    std::vector<const Bird *> best;
+    best.reserve(birds.size());
+    for (const Bird &bird : birds) {
+      best.push_back(&bird);
+    }
+    top_k = std::min(top_k, best.size());
+    std::partial_sort(best.begin(), best.begin() + top_k, best.end(),
+                      [](const Bird *a, const Bird *b) {
+                        return a->score > b->score;
+                      });
+
+    std::vector<Rect> rects;
+    rects.reserve(top_k);
+    for (std::size_t i = 0; i < top_k; i++) {
+      rects.push_back({best[i]->x, best[i]->y, best[i]->radius,
+                       best[i]->radius});
+    }
+    canvas.fill(80, 80, 80);
+    canvas.rects(rects);
   }
 };
\ No newline at end of file
@@ -0,0 +1,172 @@
+#pragma once
+#include "minefield.h"
+
+#include <algorithm>
+#include <cstdint>
+#include <stdexcept>
+#include <vector>
+
+///
+/// seeded minesweeper boards: mines are sampled with Floyd's algorithm over
+/// the cell indices, in time linear in the number of mines, the mine plane
+/// being the set of chosen cells
+///
+/// large boards are cut in chunks of ChunkCells cells whose mine counts are
+/// proportional to their candidate cells, the chunks are sampled in parallel
+/// with a pool; a board depends on the seed and the board only, not on the
+/// pool
+///
+namespace board {
+
+constexpr std::size_t ChunkCells = std::size_t{1} << 20; // a multiple of 64
+
+/// splitmix64, a small generator with the same sequence on every platform
+struct Random {
+  std::uint64_t state;
+
+  explicit Random(std::uint64_t seed) : state(seed) {}
+
+  std::uint64_t operator()() {
+    std::uint64_t z = (state += 0x9e3779b97f4a7c15ull);
+    z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ull;
+    z = (z ^ (z >> 27)) * 0x94d049bb133111ebull;
+    return z ^ (z >> 31);
+  }
+
+  /// uniform in [0, bound), without modulo bias
+  std::uint64_t below(std::uint64_t bound) {
+    const std::uint64_t limit = ~std::uint64_t{0} - ~std::uint64_t{0} % bound;
+    std::uint64_t x;
+    do {
+      x = (*this)();
+    } while (x >= limit);
+    return x % bound;
+  }
+};
+
+///
+/// \brief placeMines places mines on the cells of field that are not in
+/// excluded (sorted cell indices), uniformly for a board of one chunk
+///
+inline void placeMines(Minefield &field, std::size_t mines, std::uint64_t seed,
+                       const std::vector<std::size_t> &excluded,
+                       ThreadPool *pool = nullptr) {
+  const std::size_t cells = field.cellCount();
+  if (mines + excluded.size() > cells) {
+    throw std::runtime_error("board::placeMines; too many mines");
+  }
+
+  struct Chunk {
+    std::size_t begin;
+    std::size_t end;
+    std::vector<std::size_t> excluded; // in [begin, end)
+    std::size_t mines;
+  };
+
+  std::vector<Chunk> chunks;
+  for (std::size_t begin = 0; begin < cells; begin += ChunkCells) {
+    Chunk chunk{begin, std::min(cells, begin + ChunkCells), {}, 0};
+    for (auto id : excluded) {
+      if (id >= chunk.begin && id < chunk.end) {
+        chunk.excluded.push_back(id);
+      }
+    }
+    chunks.push_back(std::move(chunk));
+  }
+
+  // mines proportional to the candidates of each chunk, remainders go to
+  // the chunks with the largest fractions
+  const std::size_t candidates = cells - excluded.size();
+  std::vector<std::pair<double, std::size_t>> fractions;
+  std::size_t placed = 0;
+  for (std::size_t c = 0; c < chunks.size(); c++) {
+    const std::size_t free =
+        chunks[c].end - chunks[c].begin - chunks[c].excluded.size();
+    const double share = candidates ? double(mines) * free / candidates : 0;
+    chunks[c].mines = std::min(free, static_cast<std::size_t>(share));
+    placed += chunks[c].mines;
+    fractions.emplace_back(share - chunks[c].mines, c);
+  }
+  std::sort(fractions.begin(), fractions.end(),
+            [](const auto &a, const auto &b) {
+              return a.first != b.first ? a.first > b.first
+                                        : a.second < b.second;
+            });
+  for (std::size_t i = 0; placed < mines; i = (i + 1) % fractions.size()) {
+    auto &chunk = chunks[fractions[i].second];
+    if (chunk.mines < chunk.end - chunk.begin - chunk.excluded.size()) {
+      chunk.mines++;
+      placed++;
+    }
+  }
+
+  auto &plane = field.planes().flags(Minefield::Mine);
+  auto sample = [&](std::size_t first, std::size_t last) {
+    for (std::size_t c = first; c < last; c++) {
+      const Chunk &chunk = chunks[c];
+      Random random(seed ^ (0x632be59bd9b4e019ull * (c + 1)));
+
+      // k-th candidate cell of the chunk, skipping excluded cells
+      auto cell = [&chunk](std::size_t k) {
+        std::size_t id = chunk.begin + k;
+        for (auto e : chunk.excluded) {
+          if (e <= id) {
+            id++;
+          }
+        }
+        return id;
+      };
+
+      // Floyd: for j in [n - k, n), pick t in [0, j], take j if t is taken
+      const std::size_t n = chunk.end - chunk.begin - chunk.excluded.size();
+      for (std::size_t j = n - chunk.mines; j < n; j++) {
+        const std::size_t t = cell(random.below(j + 1));
+        plane.set(plane.test(t) ? cell(j) : t);
+      }
+    }
+  };
+
+  if (pool && chunks.size() > 1) {
+    // chunks start on word boundaries, they never write the same word
+    pool->parallelFor(chunks.size(), sample);
+  } else {
+    sample(0, chunks.size());
+  }
+}
+
+///
+/// \brief generate a board of size with mines placed from seed, the first
+/// click and its neighbors are free of mines when the board leaves room for
+/// it, else the first click alone
+///
+inline Minefield generate(Size size, std::size_t mines, std::uint64_t seed,
+                          Position first_click, ThreadPool *pool = nullptr) {
+  if (!first_click.valid(size)) {
+    throw std::runtime_error(
+        "board::generate; the first click is outside the board");
+  }
+  Minefield field(size);
+
+  std::vector<std::size_t> safe{field.planes().index(first_click)};
+  forEachNeighborIndex<EightNeighbors>(
+      size, first_click, [&safe](std::size_t id) { safe.push_back(id); });
+  if (mines + safe.size() > field.cellCount()) {
+    safe.resize(1);
+  }
+  std::sort(safe.begin(), safe.end());
+
+  placeMines(field, mines, seed, safe, pool);
+  field.countNeighbors(pool);
+  return field;
+}
+
+/// a board without safe cell
+inline Minefield generate(Size size, std::size_t mines, std::uint64_t seed,
+                          ThreadPool *pool = nullptr) {
+  Minefield field(size);
+  placeMines(field, mines, seed, {}, pool);
+  field.countNeighbors(pool);
+  return field;
+}
+
+} // namespace board
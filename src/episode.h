@@ -0,0 +1,206 @@
+#pragma once
+
+#include <cstdint>
+#include <fstream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+///
+/// \brief The FlapStream class stores the decisions of one bird
+/// decisions are run length encoded, runs alternate between "no flap" and
+/// "flap" starting with "no flap" (the first run may be empty)
+/// each run length is a LEB128 varint
+///
+class FlapStream {
+  std::vector<std::uint8_t> m_bytes; // closed runs
+  std::uint32_t m_run{0};            // length of the open run
+  bool m_flap{false};                // value of the open run
+  std::uint32_t m_size{0};
+
+  static void putVarint(std::vector<std::uint8_t> &bytes, std::uint32_t v) {
+    while (v >= 0x80) {
+      bytes.push_back(static_cast<std::uint8_t>(v | 0x80));
+      v >>= 7;
+    }
+    bytes.push_back(static_cast<std::uint8_t>(v));
+  }
+
+public:
+  FlapStream() = default;
+
+  /// rebuild a stream from its encoding, for reading only
+  FlapStream(std::vector<std::uint8_t> bytes, std::uint32_t size)
+      : m_bytes(std::move(bytes)), m_size(size) {}
+
+  void push(bool flap) {
+    if (flap != m_flap) {
+      putVarint(m_bytes, m_run);
+      m_flap = flap;
+      m_run = 0;
+    }
+    m_run++;
+    m_size++;
+  }
+
+  /// number of decisions
+  std::uint32_t size() const { return m_size; }
+
+  /// encoded stream, including the open run
+  std::vector<std::uint8_t> bytes() const {
+    auto bytes = m_bytes;
+    if (m_run > 0) {
+      putVarint(bytes, m_run);
+    }
+    return bytes;
+  }
+
+  ///
+  /// \brief The Reader class decodes a stream one decision at a time
+  /// decisions past the end of the stream are "no flap"
+  ///
+  class Reader {
+    std::vector<std::uint8_t> m_bytes;
+    std::size_t m_pos{0};
+    std::uint32_t m_run{0};
+    bool m_flap{true}; // toggled when the first run is read
+
+    std::uint32_t getVarint() {
+      std::uint32_t v = 0;
+      for (int shift = 0; m_pos < m_bytes.size(); shift += 7) {
+        auto byte = m_bytes[m_pos++];
+        v |= static_cast<std::uint32_t>(byte & 0x7f) << shift;
+        if (!(byte & 0x80)) {
+          break;
+        }
+      }
+      return v;
+    }
+
+  public:
+    Reader() = default;
+    explicit Reader(const FlapStream &stream) : m_bytes(stream.bytes()) {}
+
+    bool next() {
+      while (m_run == 0) {
+        if (m_pos >= m_bytes.size()) {
+          return false;
+        }
+        m_run = getVarint();
+        m_flap = !m_flap;
+      }
+      m_run--;
+      return m_flap;
+    }
+  };
+};
+
+///
+/// \brief The Episode struct records one generation of flappy bird
+/// pipes are replayed from the course seed, birds from their decisions,
+/// no neural network is needed to reproduce the episode
+///
+struct Episode {
+
+  struct Start {
+    int x;
+    int y;
+    std::uint32_t tick; // bird enters the episode before this tick
+  };
+
+  std::uint32_t seed{0};
+  int width{0};
+  int height{0};
+  std::vector<Start> starts;      // indexed by bird id
+  std::vector<FlapStream> flaps; // indexed by bird id
+
+  Episode() = default;
+  Episode(std::uint32_t seed, int width, int height)
+      : seed{seed}, width{width}, height{height} {}
+
+  /// returns the id of the new bird
+  int addBird(int x, int y, std::uint32_t tick) {
+    starts.push_back({x, y, tick});
+    flaps.emplace_back();
+    return static_cast<int>(flaps.size()) - 1;
+  }
+
+  void record(int id, bool flap) { flaps[id].push(flap); }
+
+  void save(std::string filename) const {
+    std::ofstream f(filename, std::ios::binary);
+    auto put = [&f](std::uint32_t v) {
+      const char bytes[4] = {char(v), char(v >> 8), char(v >> 16),
+                             char(v >> 24)};
+      f.write(bytes, 4);
+    };
+
+    f.write(Magic, 4);
+    put(Version);
+    put(seed);
+    put(width);
+    put(height);
+    put(flaps.size());
+    for (std::size_t id = 0; id < flaps.size(); id++) {
+      auto bytes = flaps[id].bytes();
+      put(starts[id].x);
+      put(starts[id].y);
+      put(starts[id].tick);
+      put(flaps[id].size());
+      put(bytes.size());
+      f.write(reinterpret_cast<const char *>(bytes.data()), bytes.size());
+    }
+    if (!f) {
+      throw std::runtime_error("Episode::save; can not write " + filename);
+    }
+  }
+
+  static Episode Load(std::string filename) {
+    std::ifstream f(filename, std::ios::binary | std::ios::ate);
+    const std::streamoff file_size = f.tellg();
+    f.seekg(0);
+    auto get = [&f]() {
+      unsigned char bytes[4] = {};
+      f.read(reinterpret_cast<char *>(bytes), 4);
+      return std::uint32_t(bytes[0]) | std::uint32_t(bytes[1]) << 8 |
+             std::uint32_t(bytes[2]) << 16 | std::uint32_t(bytes[3]) << 24;
+    };
+
+    char magic[4] = {};
+    f.read(magic, 4);
+    if (!f || std::string(magic, 4) != std::string(Magic, 4) ||
+        get() != Version) {
+      throw std::runtime_error("Episode::Load; " + filename +
+                               " is not an episode file");
+    }
+
+    Episode e;
+    e.seed = get();
+    e.width = static_cast<int>(get());
+    e.height = static_cast<int>(get());
+    const auto count = get();
+    for (std::uint32_t id = 0; id < count && f; id++) {
+      Start start;
+      start.x = static_cast<int>(get());
+      start.y = static_cast<int>(get());
+      start.tick = get();
+      const auto size = get();
+      // the length is read from the file, check it before allocating
+      const std::streamoff length = get();
+      if (!f || length > file_size - f.tellg()) {
+        break;
+      }
+      std::vector<std::uint8_t> bytes(static_cast<std::size_t>(length));
+      f.read(reinterpret_cast<char *>(bytes.data()), bytes.size());
+      e.starts.push_back(start);
+      e.flaps.emplace_back(std::move(bytes), size);
+    }
+    if (!f || e.flaps.size() != count) {
+      throw std::runtime_error("Episode::Load; " + filename + " is truncated");
+    }
+    return e;
+  }
+
+  static constexpr char Magic[4] = {'F', 'B', 'E', 'P'};
+  static constexpr std::uint32_t Version = 1;
+};
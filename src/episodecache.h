@@ -0,0 +1,95 @@
+#pragma once
+
+#include <cstdint>
+#include <list>
+#include <unordered_map>
+
+///
+/// \brief The EpisodeCache class remembers how a brain did on a course
+/// entries are keyed by (brain hash, course seed) and evicted least recently
+/// used first; the owner must clear it when the rules of the game change
+///
+class EpisodeCache {
+public:
+  struct Key {
+    std::uint64_t brain;
+    std::uint32_t seed;
+
+    bool operator==(const Key &other) const {
+      return brain == other.brain && seed == other.seed;
+    }
+  };
+
+  struct Entry {
+    double score;
+    long death_tick; // ticks played before the bird died or finished
+  };
+
+  struct Stats {
+    long hits{0};
+    long misses{0};
+
+    double hitRate() const {
+      return hits + misses > 0 ? double(hits) / (hits + misses) : 0.0;
+    }
+  };
+
+  explicit EpisodeCache(std::size_t capacity) : m_capacity(capacity) {}
+
+  std::size_t size() const { return m_index.size(); }
+  std::size_t capacity() const { return m_capacity; }
+
+  /// the entry of key or nullptr, counted in stats()
+  const Entry *find(const Key &key) {
+    auto it = m_index.find(key);
+    if (it == m_index.end()) {
+      m_stats.misses++;
+      return nullptr;
+    }
+    m_stats.hits++;
+    m_lru.splice(m_lru.begin(), m_lru, it->second);
+    return &it->second->second;
+  }
+
+  void insert(const Key &key, const Entry &entry) {
+    if (m_capacity == 0) {
+      return;
+    }
+    auto it = m_index.find(key);
+    if (it != m_index.end()) {
+      it->second->second = entry;
+      m_lru.splice(m_lru.begin(), m_lru, it->second);
+      return;
+    }
+    if (m_index.size() == m_capacity) {
+      m_index.erase(m_lru.back().first);
+      m_lru.pop_back();
+    }
+    m_lru.emplace_front(key, entry);
+    m_index.emplace(key, m_lru.begin());
+  }
+
+  void clear() {
+    m_lru.clear();
+    m_index.clear();
+  }
+
+  /// lookups since the last resetStats()
+  const Stats &stats() const { return m_stats; }
+  void resetStats() { m_stats = Stats{}; }
+
+private:
+  struct KeyHash {
+    std::size_t operator()(const Key &key) const {
+      const std::uint64_t seed = key.seed * 0x9e3779b97f4a7c15ull;
+      return static_cast<std::size_t>(key.brain ^ seed);
+    }
+  };
+
+  using Item = std::pair<Key, Entry>;
+
+  std::size_t m_capacity;
+  std::list<Item> m_lru; // most recently used first
+  std::unordered_map<Key, std::list<Item>::iterator, KeyHash> m_index;
+  Stats m_stats;
+};
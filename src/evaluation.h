@@ -0,0 +1,361 @@
+#pragma once
+
+#include "rollout.h"
+#include "transport.h"
+
+#include <atomic>
+#include <cstring>
+#include <iostream>
+#include <memory>
+#include <string>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/wait.h>
+
+namespace evaluation {
+
+/// scores are written by workers without locks
+static_assert(std::atomic<double>::is_always_lock_free,
+              "worker results need lock-free atomics");
+
+///
+/// \brief The Header struct starts the shared segment, it is followed by
+/// the course seeds, the packed brains and the result array
+///
+/// packed brain format: parameterCount() doubles in the order of
+/// NeuralNetwork::parameters(), all brains share the header topology
+///
+struct Header {
+  static constexpr std::uint32_t Magic = 0x56454246; // "FBEV"
+  static constexpr std::uint32_t Version = 1;
+
+  std::uint32_t magic{Magic};
+  std::uint32_t version{Version};
+  std::int32_t inputs{0};
+  std::int32_t hiddens{0};
+  std::int32_t outputs{0};
+  std::uint32_t seeds{0};
+  std::uint64_t brains{0};
+  std::uint64_t parameters{0}; // per brain
+  VectorEnv::Config config;
+};
+
+///
+/// \brief The Layout struct gives the offsets of the parts of a segment
+///
+struct Layout {
+  std::size_t seeds;
+  std::size_t brains;
+  std::size_t results;
+  std::size_t bytes;
+
+  static std::size_t align(std::size_t offset) {
+    return (offset + 63) / 64 * 64;
+  }
+
+  Layout(std::size_t brain_count, std::size_t parameters,
+         std::size_t seed_count) {
+    seeds = align(sizeof(Header));
+    brains = align(seeds + seed_count * sizeof(std::uint32_t));
+    results = align(brains + brain_count * parameters * sizeof(double));
+    bytes = align(results + brain_count * sizeof(std::atomic<double>));
+  }
+};
+
+///
+/// \brief The Message struct is the whole protocol between a coordinator and
+/// its workers: Evaluate assigns brains [begin, end) of the segment, the
+/// worker answers Done once their scores are in the result array
+///
+struct Message {
+  enum Type : std::uint32_t { Evaluate = 1, Done, Quit };
+
+  std::uint32_t type{Quit};
+  std::uint32_t generation{0};
+  std::uint64_t begin{0};
+  std::uint64_t end{0};
+  std::uint64_t bytes{0}; // segment size
+  std::int64_t ticks{0};  // bird ticks simulated, in Done
+  char segment[64]{};     // shared memory name
+};
+
+///
+/// \brief The SharedSegment class maps a named POSIX shared memory object
+///
+class SharedSegment {
+  std::string m_name;
+  void *m_data{nullptr};
+  std::size_t m_size{0};
+  bool m_owner{false};
+
+  void map(int fd, std::size_t size) {
+    m_data = ::mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    ::close(fd);
+    if (m_data == MAP_FAILED) {
+      m_data = nullptr;
+      throw std::runtime_error("SharedSegment; can not map " + m_name + ": " +
+                               std::strerror(errno));
+    }
+    m_size = size;
+  }
+
+  void unmap() {
+    if (m_data) {
+      ::munmap(m_data, m_size);
+      m_data = nullptr;
+      m_size = 0;
+    }
+  }
+
+public:
+  SharedSegment() = default;
+  ~SharedSegment() {
+    unmap();
+    if (m_owner) {
+      ::shm_unlink(m_name.c_str());
+    }
+  }
+
+  SharedSegment(const SharedSegment &) = delete;
+  SharedSegment &operator=(const SharedSegment &) = delete;
+
+  /// create (or grow) and map the segment, it is removed on destruction
+  void create(const std::string &name, std::size_t size) {
+    unmap();
+    m_name = name;
+    m_owner = true;
+    const int fd = ::shm_open(name.c_str(), O_CREAT | O_RDWR, 0600);
+    if (fd < 0 || ::ftruncate(fd, static_cast<off_t>(size)) != 0) {
+      throw std::runtime_error("SharedSegment::create; " + name + ": " +
+                               std::strerror(errno));
+    }
+    map(fd, size);
+  }
+
+  /// map an existing segment
+  void open(const std::string &name, std::size_t size) {
+    unmap();
+    m_name = name;
+    const int fd = ::shm_open(name.c_str(), O_RDWR, 0600);
+    if (fd < 0) {
+      throw std::runtime_error("SharedSegment::open; " + name + ": " +
+                               std::strerror(errno));
+    }
+    map(fd, size);
+  }
+
+  const std::string &name() const { return m_name; }
+  std::size_t size() const { return m_size; }
+  char *data() const { return static_cast<char *>(m_data); }
+
+  Header &header() const { return *reinterpret_cast<Header *>(data()); }
+  std::uint32_t *seeds() const {
+    const Header &h = header();
+    return reinterpret_cast<std::uint32_t *>(
+        data() + Layout(h.brains, h.parameters, h.seeds).seeds);
+  }
+  double *brains() const {
+    const Header &h = header();
+    return reinterpret_cast<double *>(
+        data() + Layout(h.brains, h.parameters, h.seeds).brains);
+  }
+  std::atomic<double> *results() const {
+    const Header &h = header();
+    return reinterpret_cast<std::atomic<double> *>(
+        data() + Layout(h.brains, h.parameters, h.seeds).results);
+  }
+};
+
+///
+/// \brief runWorker evaluates the ranges it is assigned until Quit or until
+/// the coordinator goes away
+///
+inline void runWorker(Transport &transport) {
+  SharedSegment segment;
+  ThreadPool pool(1);
+  Message message;
+
+  while (transport.receive(message) && message.type == Message::Evaluate) {
+    if (segment.name() != message.segment || segment.size() != message.bytes) {
+      segment.open(message.segment, message.bytes);
+    }
+    const Header &header = segment.header();
+    if (header.magic != Header::Magic || header.version != Header::Version) {
+      throw std::runtime_error("runWorker; not an evaluation segment");
+    }
+
+    NeuralNetwork brain(header.inputs, header.hiddens, header.outputs);
+    std::vector<NeuralNetwork> brains;
+    brains.reserve(message.end - message.begin);
+    for (auto i = message.begin; i < message.end; i++) {
+      brain.setParameters(segment.brains() + i * header.parameters);
+      brains.push_back(brain);
+    }
+    const std::uint32_t *seeds = segment.seeds();
+    auto result = rollout(brains, {seeds, seeds + header.seeds},
+                          header.config, pool);
+
+    auto results = segment.results();
+    for (std::size_t i = 0; i < brains.size(); i++) {
+      results[message.begin + i].store(result.scores[i],
+                                       std::memory_order_release);
+    }
+
+    Message done = message;
+    done.type = Message::Done;
+    done.ticks = result.ticks;
+    transport.send(done);
+  }
+}
+
+} // namespace evaluation
+
+///
+/// \brief The EvaluationWorkers class is the coordinator of worker processes
+/// forked on the local machine: brains are published in a shared memory
+/// segment, each worker plays an index range of the population headlessly
+/// and writes the scores in the shared result array
+///
+class EvaluationWorkers {
+  evaluation::SharedSegment m_segment;
+  std::vector<std::unique_ptr<Transport>> m_transports;
+  std::vector<pid_t> m_pids;
+  std::uint32_t m_generation{0};
+
+public:
+  explicit EvaluationWorkers(std::size_t processes) {
+    const std::string name = "/flappy_eval_" + std::to_string(::getpid());
+    m_segment.create(name, evaluation::Layout(0, 0, 0).bytes);
+
+    for (std::size_t i = 0; i < std::max<std::size_t>(processes, 1); i++) {
+      auto ends = SocketTransport::pair();
+      const pid_t pid = ::fork();
+      if (pid < 0) {
+        throw std::runtime_error(
+            std::string("EvaluationWorkers; fork failed: ") +
+            std::strerror(errno));
+      }
+      if (pid == 0) {
+        // the worker only keeps its own end
+        for (auto &transport : m_transports) {
+          static_cast<SocketTransport &>(*transport).close();
+        }
+        ends.first.close();
+        int status = 0;
+        try {
+          evaluation::runWorker(ends.second);
+        } catch (const std::exception &e) {
+          std::cerr << "evaluation worker: " << e.what() << '\n';
+          status = 1;
+        }
+        ::_exit(status);
+      }
+      ends.second.close();
+      m_transports.push_back(
+          std::make_unique<SocketTransport>(std::move(ends.first)));
+      m_pids.push_back(pid);
+    }
+  }
+
+  ~EvaluationWorkers() {
+    evaluation::Message quit;
+    for (auto &transport : m_transports) {
+      try {
+        transport->send(quit);
+      } catch (const std::exception &) {
+        // worker already gone
+      }
+    }
+    m_transports.clear();
+    for (auto pid : m_pids) {
+      ::waitpid(pid, nullptr, 0);
+    }
+  }
+
+  EvaluationWorkers(const EvaluationWorkers &) = delete;
+  EvaluationWorkers &operator=(const EvaluationWorkers &) = delete;
+
+  std::size_t size() const { return m_pids.size(); }
+
+  /// same result as rollout(), brains must share one topology
+  RolloutResult evaluate(const std::vector<NeuralNetwork> &brains,
+                         const std::vector<std::uint32_t> &seeds,
+                         const VectorEnv::Config &config) {
+    RolloutResult result;
+    if (brains.empty()) {
+      return result;
+    }
+    publish(brains, seeds, config);
+
+    const std::size_t count = brains.size();
+    const std::size_t workers = std::min(size(), count);
+    evaluation::Message message;
+    message.type = evaluation::Message::Evaluate;
+    message.generation = ++m_generation;
+    message.bytes = m_segment.size();
+    std::strncpy(message.segment, m_segment.name().c_str(),
+                 sizeof(message.segment) - 1);
+
+    for (std::size_t w = 0; w < workers; w++) {
+      message.begin = count * w / workers;
+      message.end = count * (w + 1) / workers;
+      m_transports[w]->send(message);
+    }
+
+    for (std::size_t w = 0; w < workers; w++) {
+      evaluation::Message done;
+      if (!m_transports[w]->receive(done) ||
+          done.type != evaluation::Message::Done ||
+          done.generation != m_generation) {
+        throw std::runtime_error("EvaluationWorkers::evaluate; worker " +
+                                 std::to_string(w) + " failed");
+      }
+      result.ticks += done.ticks;
+    }
+
+    auto results = m_segment.results();
+    result.scores.resize(count);
+    for (std::size_t i = 0; i < count; i++) {
+      result.scores[i] = results[i].load(std::memory_order_acquire);
+    }
+    return result;
+  }
+
+private:
+  void publish(const std::vector<NeuralNetwork> &brains,
+               const std::vector<std::uint32_t> &seeds,
+               const VectorEnv::Config &config) {
+    const auto &first = brains.front();
+    const std::size_t parameters = first.parameterCount();
+    const evaluation::Layout layout(brains.size(), parameters, seeds.size());
+    if (layout.bytes != m_segment.size()) {
+      m_segment.create(m_segment.name(), layout.bytes);
+    }
+
+    auto &header = m_segment.header();
+    header = evaluation::Header{};
+    header.inputs = first.inputNodes();
+    header.hiddens = first.hiddenNodes();
+    header.outputs = first.outputNodes();
+    header.seeds = static_cast<std::uint32_t>(seeds.size());
+    header.brains = brains.size();
+    header.parameters = parameters;
+    header.config = config;
+
+    std::copy(seeds.begin(), seeds.end(), m_segment.seeds());
+    double *packed = m_segment.brains();
+    for (const auto &brain : brains) {
+      if (brain.parameterCount() != parameters) {
+        throw std::runtime_error(
+            "EvaluationWorkers::evaluate; brains must share one topology");
+      }
+      auto params = brain.parameters();
+      packed = std::copy(params.begin(), params.end(), packed);
+    }
+    auto results = m_segment.results();
+    for (std::size_t i = 0; i < brains.size(); i++) {
+      new (&results[i]) std::atomic<double>(0.0);
+    }
+  }
+};
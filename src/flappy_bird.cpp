@@ -3,34 +3,188 @@
 #include "p5/grid.h"
 
 #include "bird.h"
+#include "episode.h"
+#include "genetic.h"
+#include "halloffame.h"
+#include "p5/adaptivespeed.h"
 #include "pipe.h"
 #include <algorithm>
 #include <list>
+#include <memory>
 const int Population = 300;
 const int Velocity = 5;
 const int PipeCreation = 75;
 const int PipeWidth = 50;
 const int BirdAcc = -12;
 const int bird_pos = 20;
+// above LodPopulation living birds, only LodTopK birds are drawn
+const std::size_t LodPopulation = 1000;
+const std::size_t LodTopK = 50;
 int cycle = 10;
+bool lod = false;
+// adaptive mode fills the frame time with as many ticks as possible,
+// keeping some of the 33ms of a 30 fps frame for the event loop
+bool adaptive = false;
+AdaptiveSpeed speed{25.0};
 
 std::list<Pipe> pipes;
 std::list<Bird> birds;
 std::list<Bird> failed_birds;
 int pipe_creator_counter = 0;
 int generation_count = 0;
+Course course;
+std::uint32_t episode_tick = 0;
 
 Bird best_bird;
 
+// the best bird of each generation is archived, 'h' brings back the best
+// archived brains of all runs
+// an archive that can not be opened or written is dropped, training goes on
+// without it
+const std::size_t HallOfFameInjection = 10;
+std::unique_ptr<HallOfFame> hall_of_fame;
+
+void openHallOfFame() {
+  try {
+    hall_of_fame = std::make_unique<HallOfFame>("hall_of_fame.bin",
+                                                Bird::arena().topology());
+    std::cout << hall_of_fame->size() << " brains in " << hall_of_fame->path()
+              << ", run " << hall_of_fame->run() << '\n';
+  } catch (const std::exception &e) {
+    std::cout << e.what() << ", no hall of fame\n";
+  }
+}
+
+// contiguous copy of the living birds for the physics pass
+BirdLanes lanes;
+PipeLanes closest_lane;
+
+// each training generation is recorded, it can be saved, replayed without
+// inference or replayed with inference to verify decisions are identical
+enum class Mode { Train, Replay, Verify };
+Mode mode = Mode::Train;
+Episode episode;
+std::vector<Bird> episode_birds; // as they entered the episode, by id
+Episode last_episode;
+std::vector<Bird> last_episode_birds;
+
+// replay state
+Episode replay;
+std::vector<Bird> verified_birds; // by id, in Mode::Verify
+std::vector<FlapStream::Reader> readers;
+std::size_t replay_next = 0;
+int verify_decisions = 0;
+int verify_mismatches = 0;
+
+// training state put aside during a replay
+struct Stash {
+  std::list<Pipe> pipes;
+  std::list<Bird> birds;
+  std::list<Bird> failed_birds;
+  int pipe_creator_counter;
+  Course course;
+  std::uint32_t episode_tick;
+} training;
+
 std::list<Bird> nextGeneration(Canvas &canvas);
 
+// record a bird entering the episode, with the brain it plays with
+void addToEpisode(Bird &bird) {
+  bird.id = episode.addBird(bird.x, bird.y, episode_tick);
+  episode_birds.push_back(bird);
+}
+
+void startEpisode(Canvas &canvas, std::uint32_t seed) {
+  course = Course{seed};
+  pipes.clear();
+  pipes.emplace_back(canvas.width(), canvas.height(), PipeWidth, course);
+  pipe_creator_counter = 0;
+  episode_tick = 0;
+}
+
+// start recording the current birds on a new course
+void startTraining(Canvas &canvas) {
+  startEpisode(canvas, std::random_device{}());
+
+  episode = Episode{course.seed, canvas.width(), canvas.height()};
+  episode_birds.clear();
+  for (auto &bird : birds) {
+    addToEpisode(bird);
+  }
+}
+
+void startReplay(Canvas &canvas, Episode e, Mode m,
+                 std::vector<Bird> verified = {}) {
+  if (m == Mode::Verify && verified.size() != e.starts.size()) {
+    std::cout << "verify: the episode has " << e.starts.size()
+              << " birds, " << verified.size() << " brains are known\n";
+    return;
+  }
+
+  training = {std::move(pipes),        std::move(birds),
+              std::move(failed_birds), pipe_creator_counter,
+              course,                  episode_tick};
+  birds.clear();
+  failed_birds.clear();
+
+  if (canvas.width() != e.width || canvas.height() != e.height) {
+    canvas.setSize(e.width, e.height);
+  }
+
+  mode = m;
+  replay = std::move(e);
+  readers.clear();
+  for (const auto &flaps : replay.flaps) {
+    readers.emplace_back(flaps);
+  }
+  replay_next = 0;
+  verify_decisions = 0;
+  verify_mismatches = 0;
+
+  verified_birds = std::move(verified);
+
+  startEpisode(canvas, replay.seed);
+}
+
+// replayed birds enter the episode at their recorded tick, verified birds
+// with the brain they had, birds added during the episode included
+void spawnReplayedBirds() {
+  while (replay_next < replay.starts.size() &&
+         replay.starts[replay_next].tick == episode_tick) {
+    const auto &start = replay.starts[replay_next];
+    Bird bird = mode == Mode::Verify ? verified_birds[replay_next]
+                                     : Bird{start.x, start.y};
+    bird.id = static_cast<int>(replay_next);
+    birds.push_back(bird);
+    replay_next++;
+  }
+}
+
+void endReplay() {
+  if (mode == Mode::Verify) {
+    std::cout << "verify: " << verify_mismatches << " mismatches in "
+              << verify_decisions << " decisions\n";
+  } else {
+    std::cout << "replay: " << episode_tick << " ticks\n";
+  }
+
+  pipes = std::move(training.pipes);
+  birds = std::move(training.birds);
+  failed_birds = std::move(training.failed_birds);
+  pipe_creator_counter = training.pipe_creator_counter;
+  course = training.course;
+  episode_tick = training.episode_tick;
+  mode = Mode::Train;
+}
+
 void setup(Canvas &canvas) {
+  openHallOfFame();
 
   for (int i = 0; i < Population; i++) {
     birds.emplace_back(bird_pos, canvas.height() / 2);
   }
 
-  pipes.emplace_back(canvas.width(), canvas.height(), PipeWidth);
+  startTraining(canvas);
 }
 
 const Pipe &closestPipe(std::list<Pipe> &pipes) {
@@ -44,118 +198,144 @@ const Pipe &closestPipe(std::list<Pipe> &pipes) {
   return *it;
 }
 #include <chrono>
-void draw(Canvas &canvas) {
+// advance the simulation by one tick
+void tick(Canvas &canvas) {
+  if (mode != Mode::Train) {
+    spawnReplayedBirds();
+  }
 
-  auto start = std::chrono::steady_clock::now();
+  // update positions
+  for (auto &pipe : pipes) {
+    pipe.update(Velocity);
+  }
+  auto &closest_pipe = closestPipe(pipes);
 
-  for (int c = 0; c < cycle; c++) {
-    // update positions
-    for (auto &pipe : pipes) {
-      pipe.update(Velocity);
+  // decisions, then physics and collisions of all birds in one pass
+  lanes.resize(birds.size());
+  std::size_t i = 0;
+  for (auto &bird : birds) {
+    bool flap = false;
+    switch (mode) {
+    case Mode::Train:
+      flap = bird.think(closest_pipe, canvas.width(), canvas.height());
+      episode.record(bird.id, flap);
+      break;
+    case Mode::Replay:
+      flap = readers[bird.id].next();
+      break;
+    case Mode::Verify: {
+      bool expected = readers[bird.id].next();
+      flap = bird.think(closest_pipe, canvas.width(), canvas.height());
+      verify_decisions++;
+      verify_mismatches += flap != expected;
+      break;
     }
-    auto &closest_pipe = closestPipe(pipes);
+    }
+    lanes.x[i] = bird.x;
+    lanes.y[i] = bird.y;
+    lanes.velocity[i] = bird.velocity;
+    lanes.score[i] = bird.score;
+    lanes.flap[i] = flap;
+    i++;
+  }
 
-    int cpt = 0;
-    for (auto &bird : birds) {
-      cpt += bird.think(closest_pipe, canvas.width(), canvas.height());
-      bird.update();
+  closest_lane.x.assign(1, closest_pipe.x);
+  closest_lane.top.assign(1, closest_pipe.top);
+  closest_lane.width = closest_pipe.width;
+  closest_lane.gate = closest_pipe.gate;
+  PhysicsRules rules;
+  rules.screen_height = canvas.height();
+  stepBirds(lanes, rules, closest_lane);
+
+  i = 0;
+  for (auto it = birds.begin(); it != birds.end(); i++) {
+    auto bird = it++;
+    bird->y = lanes.y[i];
+    bird->velocity = lanes.velocity[i];
+    bird->score = lanes.score[i];
+    if (lanes.dead[i]) {
+      failed_birds.splice(failed_birds.begin(), birds, bird);
     }
-    // std::cout << "do up= " << cpt << "/" << birds.size() << std::endl;
-
-    auto failed_it = std::remove_if(
-        birds.begin(), birds.end(), [&canvas, &closest_pipe](Bird &bird) {
-          // check offscreen
-          if (bird.offscreen(canvas.height())) {
-            return true;
-          }
-          // check collision
-          if ((!(bird.x > closest_pipe.x + closest_pipe.width ||
-                 bird.x + bird.radius < closest_pipe.x)) &&
-              (!(bird.y > closest_pipe.top &&
-                 bird.y + bird.radius <
-                     closest_pipe.top + closest_pipe.gate))) {
-            return true;
-          }
-          return false;
-        });
-
-    failed_birds.splice(failed_birds.begin(), birds, failed_it, birds.end());
-
-    // std::cout << "failed birds = " << failed_birds.size() << std::endl;
-
-    // remove offscreen pipes
-    pipes.erase(
-        std::remove_if(pipes.begin(), pipes.end(),
-                       [](const Pipe &pipe) { return pipe.offscreen(); }),
-        pipes.end());
-
-    if (birds.empty()) {
+  }
+
+  // remove offscreen pipes
+  pipes.erase(
+      std::remove_if(pipes.begin(), pipes.end(),
+                     [](const Pipe &pipe) { return pipe.offscreen(); }),
+      pipes.end());
+
+  episode_tick++;
+
+  if (birds.empty()) {
+    if (mode == Mode::Train) {
+      last_episode = std::move(episode);
+      last_episode_birds = std::move(episode_birds);
       birds = nextGeneration(canvas);
-      pipe_creator_counter = PipeCreation + 1;
-      pipes.clear();
+      startTraining(canvas);
+    } else {
+      endReplay();
     }
+    return;
+  }
 
-    // create new pipe periodically
-    pipe_creator_counter++;
-    if (pipe_creator_counter > PipeCreation) {
-      pipe_creator_counter = 0;
-      pipes.emplace_back(canvas.width(), canvas.height(), PipeWidth);
-    }
+  // create new pipe periodically
+  pipe_creator_counter++;
+  if (pipe_creator_counter > PipeCreation) {
+    pipe_creator_counter = 0;
+    pipes.emplace_back(canvas.width(), canvas.height(), PipeWidth, course);
   }
+}
 
-  // drawing stuff
+void render(Canvas &canvas) {
   canvas.background(255, 255, 255);
 
-  for (const auto &pipe : pipes)
-    Pipe::draw(pipe, canvas);
-  for (auto &bird : birds) {
-    Bird::draw(bird, canvas);
+  Pipe::draw(pipes, canvas);
+  if (lod || birds.size() > LodPopulation) {
+    Bird::drawDensity(birds, canvas, LodTopK);
+  } else {
+    Bird::draw(birds, canvas);
   }
-  auto end = std::chrono::steady_clock::now();
-  /*
-    std::cout << "Elapsed time in milliseconds: "
-              << std::chrono::duration_cast<std::chrono::milliseconds>(end -
-                                                                       start)
-                     .count()
-              << " ms" << std::endl;*/
-  std::cout << std::flush;
 }
 
-void calculateFitness(std::list<Bird> &b) {
+void draw(Canvas &canvas) {
+  using ms = std::chrono::duration<double, std::milli>;
 
-  double sum =
-      std::accumulate(b.begin(), b.end(), 0.0, [](double s, const Bird &bird) {
-        return bird.score + s;
-      });
+  const int ticks = adaptive ? speed.ticks() : cycle;
+  const bool rendered = !adaptive || speed.render();
 
-  for (auto &bird : b) {
-    bird.fitness = bird.score / sum;
+  auto start = std::chrono::steady_clock::now();
+  for (int c = 0; c < ticks; c++) {
+    tick(canvas);
   }
-}
-
-std::random_device RandomDevice;
+  auto simulated = std::chrono::steady_clock::now();
 
-Bird &pickOne(std::list<Bird> &b) {
-  std::uniform_real_distribution gen{0.0, 1.0};
-  auto r = gen(RandomDevice);
+  if (rendered) {
+    render(canvas);
+  }
+  auto end = std::chrono::steady_clock::now();
 
-  auto it = b.begin();
+  speed.frame(ticks, ms(simulated - start).count(),
+              ms(end - simulated).count());
 
-  while (r > 0) {
-    r = r - it->fitness;
-    it++;
+  if (adaptive && rendered) {
+    canvas.text(std::to_string(static_cast<int>(speed.ticksPerSecond())) +
+                    " ticks/s (" + std::to_string(ticks) + " per frame)",
+                10, 20);
   }
-  it--;
-  return *it;
+  std::cout << std::flush;
 }
 
-Bird reproduce(std::list<Bird> &b, const Canvas &canvas) {
+std::random_device RandomDevice;
+
+Bird reproduce(genetic::Selection<std::list<Bird>> &selection,
+               const Canvas &canvas) {
 
-  auto &parent = pickOne(b);
+  auto &parent = selection.pick(RandomDevice);
 
   Bird child(bird_pos, canvas.height() / 2);
   child.brain = parent.brain;
   child.brain.mutate(0.1);
+  child.parent = parent.brain.hash();
 
   return child;
 }
@@ -166,7 +346,7 @@ std::list<Bird> nextGeneration(Canvas &canvas) {
   std::cout << "-----------------------------------\n";
   std::cout << "generation " << generation_count << "\n";
 
-  calculateFitness(failed_birds);
+  genetic::calculateFitness(failed_birds);
 
   // failed_birds.sort(
   //    [](const Bird &a, const Bird &b) { return a.fitness > b.fitness; });
@@ -174,8 +354,9 @@ std::list<Bird> nextGeneration(Canvas &canvas) {
   // std::cout << "generation best  score " << failed_birds.front().score <<
   // '\n';
 
+  genetic::Selection<std::list<Bird>> selection(failed_birds);
   for (int i = 0; i < Population; i++) {
-    ret.push_back(std::move(reproduce(failed_birds, canvas)));
+    ret.push_back(std::move(reproduce(selection, canvas)));
   }
 
   //  best bird
@@ -183,6 +364,19 @@ std::list<Bird> nextGeneration(Canvas &canvas) {
   if (failed_birds.front().score > best_bird.score) {
     best_bird = failed_birds.front();
   }
+
+  auto &generation_best = *std::max_element(
+      failed_birds.begin(), failed_birds.end(),
+      [](const Bird &a, const Bird &b) { return a.score < b.score; });
+  if (hall_of_fame) {
+    try {
+      hall_of_fame->add(generation_best.brain, generation_best.score,
+                        generation_count, generation_best.parent);
+    } catch (const std::exception &e) {
+      std::cout << e.what() << ", no hall of fame\n";
+      hall_of_fame.reset();
+    }
+  }
   std::cout << "all times best score " << best_bird.score << '\n';
 
   failed_birds.clear();
@@ -203,6 +397,43 @@ void keyPressed(Canvas &canvas) {
     mousePressed(canvas);
   }
 
+  if (canvas.key() == 'd') {
+    lod = !lod;
+  }
+
+  if (canvas.key() == 'a') {
+    adaptive = !adaptive;
+  }
+
+  if (mode == Mode::Train && canvas.key() == 'e' &&
+      !last_episode.flaps.empty()) {
+    last_episode.save("episode.bin");
+  }
+
+  if (mode == Mode::Train && canvas.key() == 'r') {
+    try {
+      startReplay(canvas, Episode::Load("episode.bin"), Mode::Replay);
+    } catch (const std::exception &e) {
+      // a missing or damaged file leaves the training running
+      std::cout << "replay: " << e.what() << '\n';
+    }
+  }
+
+  if (mode == Mode::Train && canvas.key() == 'v' &&
+      !last_episode.flaps.empty()) {
+    startReplay(canvas, last_episode, Mode::Verify, last_episode_birds);
+  }
+
+  if (mode == Mode::Train && canvas.key() == 'h' && hall_of_fame) {
+    for (auto index : hall_of_fame->top(HallOfFameInjection)) {
+      Bird b{bird_pos + 10, canvas.height() / 2};
+      b.brain = hall_of_fame->brain(index, Bird::arena());
+      b.parent = hall_of_fame->entry(index).hash;
+      addToEpisode(b);
+      birds.push_back(b);
+    }
+  }
+
 #ifdef JSON_SERIALIZATION
   if (canvas.key() == 's') {
 
@@ -216,13 +447,14 @@ void keyPressed(Canvas &canvas) {
       best_bird = bird;
     }
     // save it
-    best_bird.brain.save("best_bird.json");
+    best_bird.brain.toNetwork().save("best_bird.json");
   }
 
-  if (canvas.key() == 'l') {
+  if (mode == Mode::Train && canvas.key() == 'l') {
     // load best bird brain
     Bird b{bird_pos + 10, canvas.height() / 2};
-    b.brain = NeuralNetwork::Load("best_bird.json");
+    b.brain = Brain(Bird::arena(), NeuralNetwork::Load("best_bird.json"));
+    addToEpisode(b);
     birds.push_back(b);
   }
 #endif
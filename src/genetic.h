@@ -0,0 +1,58 @@
+#pragma once
+
+#include <algorithm>
+#include <numeric>
+#include <random>
+#include <vector>
+
+///
+/// genetic algorithm used to train the birds: the fitness of an individual is
+/// its share of the total score, parents are picked with a probability equal
+/// to their fitness and children are mutated copies of their parent's brain
+/// individuals need score and fitness members
+///
+namespace genetic {
+
+/// individuals share the fitness equally when every score is 0
+template <typename Population> void calculateFitness(Population &b) {
+  double sum = std::accumulate(
+      b.begin(), b.end(), 0.0,
+      [](double s, const auto &individual) { return individual.score + s; });
+
+  for (auto &individual : b) {
+    individual.fitness = sum > 0 ? individual.score / sum : 1.0 / b.size();
+  }
+}
+
+///
+/// \brief The Selection class picks individuals of a population with a
+/// probability proportional to their fitness, uniformly when no fitness is
+/// positive; the distribution is built once, the population must not change
+/// or be empty while it is used
+///
+template <typename Population> class Selection {
+public:
+  explicit Selection(Population &b) {
+    std::vector<double> weights;
+    weights.reserve(b.size());
+    for (auto &individual : b) {
+      m_individuals.push_back(&individual);
+      weights.push_back(std::max(0.0, double(individual.fitness)));
+    }
+    if (std::accumulate(weights.begin(), weights.end(), 0.0) <= 0) {
+      std::fill(weights.begin(), weights.end(), 1.0);
+    }
+    m_distribution = std::discrete_distribution<std::size_t>(weights.begin(),
+                                                             weights.end());
+  }
+
+  template <typename Generator> auto &pick(Generator &generator) {
+    return *m_individuals[m_distribution(generator)];
+  }
+
+private:
+  std::vector<typename Population::value_type *> m_individuals;
+  std::discrete_distribution<std::size_t> m_distribution;
+};
+
+} // namespace genetic
@@ -0,0 +1,243 @@
+#pragma once
+
+#include "neuralnetwork/brain.h"
+
+#include <algorithm>
+#include <cerrno>
+#include <cstdint>
+#include <cstring>
+#include <stdexcept>
+#include <string>
+#include <unordered_set>
+#include <vector>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+///
+/// \brief The HallOfFame class is a persistent archive of good brains, kept
+/// across generations and runs
+///
+/// the file is append only: a header then one fixed size record per brain,
+/// an Entry followed by its parameters laid out like Brain::parameters(), in
+/// native byte order
+/// the file is memory mapped when opened and after each add(): queries use
+/// an in memory copy of the entries, brains are copied from the mapping
+/// without parsing
+///
+class HallOfFame {
+public:
+  struct Entry {
+    double score;
+    std::uint32_t generation;
+    std::uint32_t run;    // runs are numbered each time the archive is opened
+    std::uint64_t hash;   // Brain::hash()
+    std::uint64_t parent; // hash of the parent brain, 0 if unknown
+  };
+
+  struct Header {
+    char magic[4];
+    std::uint32_t version;
+    std::uint32_t inputs;
+    std::uint32_t hiddens;
+    std::uint32_t outputs;
+    std::uint32_t reserved;
+  };
+
+  static constexpr char Magic[4] = {'F', 'B', 'H', 'F'};
+  static constexpr std::uint32_t Version = 1;
+
+  /// open or create the archive of path, it must hold brains of topology
+  HallOfFame(std::string path, const Topology &topology)
+      : m_path(std::move(path)), m_topology(topology),
+        m_stride(sizeof(Entry) + topology.parameterCount() * sizeof(double)) {
+    m_fd = ::open(m_path.c_str(), O_RDWR | O_CREAT | O_APPEND, 0644);
+    if (m_fd < 0) {
+      throw std::runtime_error("HallOfFame; can not open " + m_path + ": " +
+                               std::strerror(errno));
+    }
+    try {
+      load();
+    } catch (...) {
+      unmap();
+      ::close(m_fd);
+      throw;
+    }
+  }
+
+  ~HallOfFame() {
+    unmap();
+    ::close(m_fd);
+  }
+
+  HallOfFame(const HallOfFame &) = delete;
+  HallOfFame &operator=(const HallOfFame &) = delete;
+
+  const std::string &path() const { return m_path; }
+  const Topology &topology() const { return m_topology; }
+  std::size_t size() const { return m_entries.size(); }
+  std::uint32_t run() const { return m_run; }
+  bool contains(std::uint64_t hash) const { return m_hashes.count(hash) > 0; }
+
+  const Entry &entry(std::size_t index) const { return m_entries[index]; }
+  const double *parameters(std::size_t index) const {
+    return reinterpret_cast<const double *>(
+        static_cast<const char *>(m_data) + sizeof(Header) +
+        index * m_stride + sizeof(Entry));
+  }
+
+  /// a copy of the archived brain index in arena
+  Brain brain(std::size_t index, BrainArena &arena) const {
+    checkTopology(arena.topology());
+    return Brain(arena, parameters(index));
+  }
+
+  /// indices of the n best scores, best first, older first on ties
+  std::vector<std::size_t> top(std::size_t n) const {
+    std::vector<std::size_t> indices(m_entries.size());
+    for (std::size_t i = 0; i < indices.size(); i++) {
+      indices[i] = i;
+    }
+    n = std::min(n, indices.size());
+    std::partial_sort(indices.begin(), indices.begin() + n, indices.end(),
+                      [this](std::size_t a, std::size_t b) {
+                        if (m_entries[a].score != m_entries[b].score) {
+                          return m_entries[a].score > m_entries[b].score;
+                        }
+                        return a < b;
+                      });
+    indices.resize(n);
+    return indices;
+  }
+
+  /// append brain to the archive, returns false if it is already archived
+  bool add(const Brain &brain, double score, std::uint32_t generation,
+           std::uint64_t parent = 0) {
+    checkTopology(brain.topology());
+    const Entry entry{score, generation, m_run, brain.hash(), parent};
+    if (contains(entry.hash)) {
+      return false;
+    }
+
+    m_buffer.resize(m_stride);
+    std::memcpy(m_buffer.data(), &entry, sizeof(Entry));
+    std::memcpy(m_buffer.data() + sizeof(Entry), brain.parameters(),
+                m_stride - sizeof(Entry));
+    write(m_buffer.data(), m_buffer.size());
+
+    m_entries.push_back(entry);
+    m_hashes.insert(entry.hash);
+    map(sizeof(Header) + m_entries.size() * m_stride);
+    return true;
+  }
+
+private:
+  std::string m_path;
+  Topology m_topology;
+  std::size_t m_stride; // bytes of a record
+  int m_fd{-1};
+  void *m_data{nullptr};
+  std::size_t m_size{0};
+  std::uint32_t m_run{0};
+  std::vector<Entry> m_entries;
+  std::unordered_set<std::uint64_t> m_hashes;
+  std::vector<char> m_buffer;
+
+  void checkTopology(const Topology &topology) const {
+    if (topology.inputs != m_topology.inputs ||
+        topology.hiddens != m_topology.hiddens ||
+        topology.outputs != m_topology.outputs) {
+      throw std::runtime_error("HallOfFame; " + m_path +
+                               " holds brains of another topology");
+    }
+  }
+
+  void write(const char *bytes, std::size_t size) {
+    while (size > 0) {
+      const ssize_t n = ::write(m_fd, bytes, size);
+      if (n < 0 && errno == EINTR) {
+        continue;
+      }
+      if (n <= 0) {
+        throw std::runtime_error("HallOfFame; can not write " + m_path + ": " +
+                                 std::strerror(errno));
+      }
+      bytes += n;
+      size -= static_cast<std::size_t>(n);
+    }
+  }
+
+  void load() {
+    struct stat st {};
+    if (::fstat(m_fd, &st) != 0) {
+      throw std::runtime_error("HallOfFame; can not stat " + m_path + ": " +
+                               std::strerror(errno));
+    }
+    auto size = static_cast<std::size_t>(st.st_size);
+
+    if (size == 0) {
+      Header header{};
+      std::memcpy(header.magic, Magic, 4);
+      header.version = Version;
+      header.inputs = static_cast<std::uint32_t>(m_topology.inputs);
+      header.hiddens = static_cast<std::uint32_t>(m_topology.hiddens);
+      header.outputs = static_cast<std::uint32_t>(m_topology.outputs);
+      write(reinterpret_cast<const char *>(&header), sizeof(header));
+      size = sizeof(header);
+    }
+
+    Header header{};
+    if (size < sizeof(Header) ||
+        ::pread(m_fd, &header, sizeof(header), 0) != sizeof(header) ||
+        std::memcmp(header.magic, Magic, 4) != 0 ||
+        header.version != Version) {
+      throw std::runtime_error("HallOfFame; " + m_path +
+                               " is not a hall of fame");
+    }
+    checkTopology(Topology(static_cast<int>(header.inputs),
+                           static_cast<int>(header.hiddens),
+                           static_cast<int>(header.outputs)));
+
+    // a record cut by a crash is dropped, appends must stay aligned
+    const std::size_t count = (size - sizeof(Header)) / m_stride;
+    if (sizeof(Header) + count * m_stride != size) {
+      size = sizeof(Header) + count * m_stride;
+      if (::ftruncate(m_fd, static_cast<off_t>(size)) != 0) {
+        throw std::runtime_error("HallOfFame; can not truncate " + m_path +
+                                 ": " + std::strerror(errno));
+      }
+    }
+
+    map(size);
+    m_entries.resize(count);
+    for (std::size_t i = 0; i < count; i++) {
+      std::memcpy(&m_entries[i],
+                  static_cast<const char *>(m_data) + sizeof(Header) +
+                      i * m_stride,
+                  sizeof(Entry));
+      m_hashes.insert(m_entries[i].hash);
+      m_run = std::max(m_run, m_entries[i].run + 1);
+    }
+  }
+
+  void map(std::size_t size) {
+    unmap();
+    m_data = ::mmap(nullptr, size, PROT_READ, MAP_SHARED, m_fd, 0);
+    if (m_data == MAP_FAILED) {
+      m_data = nullptr;
+      throw std::runtime_error("HallOfFame; can not map " + m_path + ": " +
+                               std::strerror(errno));
+    }
+    m_size = size;
+  }
+
+  void unmap() {
+    if (m_data) {
+      ::munmap(m_data, m_size);
+      m_data = nullptr;
+      m_size = 0;
+    }
+  }
+};
@@ -0,0 +1,106 @@
+#pragma once
+#include "p5/bitplane.h"
+#include "p5/boxsum.h"
+
+///
+/// \brief The Minefield class is a minesweeper board without display, it
+/// follows the rules of minesweeper.cpp
+/// cells are bit planes (mine, revealed, marked) and a nibble plane of
+/// neighbor mine counts: a 10 million cell board takes less than 10 MB
+///
+class Minefield {
+public:
+  enum Flag { Mine, Revealed, Marked, FlagCount };
+  enum Count { NeighborMines, CountCount };
+  using Planes = PlanarGrid<FlagCount, CountCount>;
+
+  explicit Minefield(Size size) : m_planes(size) {}
+
+  Size size() const { return m_planes.size(); }
+  std::size_t cellCount() const { return m_planes.cellCount(); }
+  Planes &planes() { return m_planes; }
+  const Planes &planes() const { return m_planes; }
+
+  bool mine(Position pos) const { return m_planes.flag(Mine, pos); }
+  bool revealed(Position pos) const { return m_planes.flag(Revealed, pos); }
+  bool marked(Position pos) const { return m_planes.flag(Marked, pos); }
+  int neighborMines(Position pos) const {
+    return m_planes.count(NeighborMines, pos);
+  }
+
+  /// neighbor counts are stale until countNeighbors()
+  void placeMine(Position pos) { m_planes.setFlag(Mine, pos); }
+
+  /// fill the neighbor mine count of every cell with the box sum stencil of
+  /// neighborSums, in parallel with a pool
+  void countNeighbors(ThreadPool *pool = nullptr) {
+    const auto &mines = m_planes.flags(Mine);
+    std::vector<std::uint8_t> bytes(cellCount());
+    std::vector<std::uint8_t> sums(cellCount());
+    for (std::size_t id = 0; id < bytes.size(); id++) {
+      bytes[id] = mines.test(id);
+    }
+
+    neighborSums(size(), bytes.data(), sums.data(), pool);
+
+    auto &counts = m_planes.counts(NeighborMines);
+    for (std::size_t id = 0; id < sums.size(); id++) {
+      counts.set(id, sums[id]);
+    }
+  }
+
+  std::size_t mineCount() const { return m_planes.flags(Mine).count(); }
+  std::size_t revealedCount() const {
+    return m_planes.flags(Revealed).count();
+  }
+
+  bool lost() const { return m_lost; }
+  bool won() const {
+    return !m_lost && revealedCount() + mineCount() == cellCount();
+  }
+  bool finished() const { return m_lost || won(); }
+
+  ///
+  /// \brief reveal is a left click: a mine loses the game and reveals every
+  /// cell, an empty cell reveals its neighbors
+  /// returns the number of cells revealed by the click
+  ///
+  std::size_t reveal(Position pos) {
+    return reveal(pos, [](std::size_t) {});
+  }
+
+  /// reveal calling on_reveal(index) for each cell the click reveals, unless
+  /// the click is on a mine
+  template <typename F> std::size_t reveal(Position pos, F &&on_reveal) {
+    if (m_lost || !pos.valid(size()) || revealed(pos)) {
+      return 0;
+    }
+    if (mine(pos)) {
+      m_lost = true;
+      const auto hidden = cellCount() - revealedCount();
+      m_planes.flags(Revealed).fill(true);
+      return hidden;
+    }
+
+    auto &revealed = m_planes.flags(Revealed);
+    const auto &counts = m_planes.counts(NeighborMines);
+    return floodFill(
+        size(), pos, [&revealed](std::size_t id) { return !revealed.test(id); },
+        [&](std::size_t id) {
+          revealed.set(id);
+          on_reveal(id);
+          return counts.get(id) == 0;
+        });
+  }
+
+  /// a right click: toggles the marker of a hidden cell
+  void mark(Position pos) {
+    if (!revealed(pos)) {
+      m_planes.flags(Marked).flip(m_planes.index(pos));
+    }
+  }
+
+private:
+  Planes m_planes;
+  bool m_lost{false};
+};
@@ -3,7 +3,10 @@
 #include "p5/application.h"
 #include "p5/grid.h"
 
-#include <set>
+#include "boardgenerator.h"
+
+#include <iostream>
+#include <random>
 
 const Size grid_size{10, 10};
 const int MineCount = 10;
@@ -30,42 +33,53 @@ int revealed = 0;
 
 bool isFinished() { return win || game_over; }
 
-void setup(Canvas &canvas) {
+// cells are repainted when they change, frames without clicks paint nothing
+void setup(Canvas &canvas) { canvas.partialRepaint(true); }
 
-  // fill the grid with mines
-  std::set<Position> mines;
-  while (mines.size() < MineCount) {
-    int col = random(grid_size.column);
-    int row = random(grid_size.row);
-    Position pos{col, row};
+// mines are placed at the first click, which is always safe
+bool generated = false;
 
-    if (auto [it, inserted] = mines.insert(pos); inserted) {
-      grid.at(pos).mine = true;
-    }
-  }
+void generate(Position first_click) {
+  const std::uint64_t seed = std::random_device{}();
+  std::cout << "board seed " << seed << '\n';
 
-  // fill other cells with number of neighbors mines
-  grid.forEach([](Cell &cell) {
-    if (cell.mine == false) {
-      int count = 0;
-      grid.forEachNeighbor(cell, [&count](Cell &neighbor) {
-        if (neighbor.mine) {
-          count++;
-        }
-      });
-      cell.mine_neighbor_count = count;
-    }
+  auto field = board::generate(grid_size, MineCount, seed, first_click);
+  grid.forEach([&field](Cell &cell) {
+    cell.mine = field.mine(cell.position);
+    cell.mine_neighbor_count = field.neighborMines(cell.position);
   });
+  generated = true;
 }
 
-void draw(Canvas &canvas) {
+Rect cellRect(Canvas &canvas, Position position) {
+  return Rect{canvas.width() * position.column / grid_size.column,
+              canvas.height() * position.row / grid_size.row,
+              canvas.width() / grid_size.column,
+              canvas.height() / grid_size.row};
+}
 
-  canvas.background(255, 255, 255);
+// ask the canvas to repaint the dirty cells, outlines included
+void redrawDirty(Canvas &canvas) {
+  grid.forEachDirty([&canvas](const Cell &cell) {
+    const Rect r = cellRect(canvas, cell.position);
+    canvas.redraw(Rect{r.x, r.y, r.w + 1, r.h + 1});
+  });
+}
 
-  // Render all cells
-  grid.forEach([&canvas](const Cell &cell) { cell.draw(canvas); });
+void draw(Canvas &canvas) {
+
+  if (canvas.fullRedraw()) {
+    canvas.background(255, 255, 255);
+    grid.forEach([&canvas](const Cell &cell) { cell.draw(canvas); });
+  } else {
+    grid.forEachDirty([&canvas](const Cell &cell) { cell.draw(canvas); });
+  }
+  grid.clearDirty();
 
   if (isFinished()) {
+    // the text moves over the cells, the whole board is painted again
+    grid.setAllDirty();
+    canvas.redraw(Rect{0, 0, canvas.width(), canvas.height()});
     if (game_over) {
       canvas.text("GAME OVER", go_anim, go_anim);
     }
@@ -79,14 +93,14 @@ void draw(Canvas &canvas) {
 }
 
 void reveal(Cell &cell) {
-
-  if (cell.revealed == false) {
-    cell.revealed = true;
-    revealed++;
-    if (cell.mine_neighbor_count == 0) {
-      grid.forEachNeighbor(cell, [](Cell &cell) { reveal(cell); });
-    }
-  }
+  // empty cells reveal their neighbors
+  revealed += grid.floodFill(
+      cell.position, [](const Cell &cell) { return !cell.revealed; },
+      [](Cell &cell) {
+        cell.revealed = true;
+        grid.setDirty(cell);
+        return cell.mine_neighbor_count == 0;
+      });
 }
 
 Cell &cellFromWindow(Canvas &canvas, int x, int y) {
@@ -106,10 +120,14 @@ void mousePressed(Canvas &canvas) {
   auto &cell = cellFromWindow(canvas, canvas.mouseX(), canvas.mouseY());
 
   if (canvas.isMouseLeft()) {
+    if (!generated) {
+      generate(cell.position);
+    }
 
     if (cell.mine == true) {
       // game over
       grid.forEach([&canvas](Cell &cell) { cell.revealed = true; });
+      grid.setAllDirty();
       game_over = true;
     } else {
       reveal(cell);
@@ -121,34 +139,39 @@ void mousePressed(Canvas &canvas) {
 
   if (canvas.isMouseRight() && cell.revealed == false) {
     cell.mark();
+    grid.setDirty(cell);
   }
+
+  redrawDirty(canvas);
 }
 
 void Cell::draw(Canvas &canvas) const {
 
-  int x_min = canvas.width() * position.column / grid_size.column;
-  int y_min = canvas.height() * position.row / grid_size.row;
-  int width = canvas.width() / grid_size.column;
-  int height = canvas.height() / grid_size.row;
+  const Rect r = cellRect(canvas, position);
+  const int x_min = r.x;
+  const int y_min = r.y;
+  const int width = r.w;
+  const int height = r.h;
 
+  // cells are painted over the previous frame, the rect covers it
   canvas.stroke(80, 80, 80);
-  canvas.fill(255, 255, 255);
   if (revealed == false) {
     if (!marker)
       canvas.fill(200, 200, 200);
     else
       canvas.fill(255, 0, 0);
-    canvas.rect(x_min, y_min, width, height);
+  } else {
+    canvas.fill(255, 255, 255);
+  }
+  canvas.rect(x_min, y_min, width, height);
 
-  } else if (mine == true) {
+  if (revealed == true && mine == true) {
     canvas.line(x_min, y_min, x_min + width, y_min + height);
     canvas.line(x_min + width, y_min, x_min, y_min + height);
-  } else if (mine_neighbor_count > 0) {
+  } else if (revealed == true && mine_neighbor_count > 0) {
     canvas.text(std::to_string(mine_neighbor_count), x_min + width / 2,
                 y_min + height / 2);
   }
-  canvas.noFill();
-  canvas.rect(x_min, y_min, width, height);
 }
 
 /// magic happens here
@@ -0,0 +1,116 @@
+#pragma once
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <memory_resource>
+#include <vector>
+
+///
+/// \brief The BumpArena class is a memory resource for short lived matrices
+/// allocation moves a pointer forward, deallocation does nothing, memory is
+/// reclaimed by rewinding the arena to a previous mark
+/// chunks are kept when rewinding: once warm, an arena does not allocate
+///
+/// usage:
+///   auto &arena = BumpArena::local();
+///   BumpArena::Scope scope(arena); // rewinds the arena when leaving
+///   Matrix m(rows, cols, &arena);
+///
+/// every allocation made in a scope must be dead when the scope ends
+///
+class BumpArena : public std::pmr::memory_resource {
+public:
+  struct Mark {
+    std::size_t chunk;
+    std::size_t offset;
+  };
+
+  ///
+  /// \brief The Scope class rewinds the arena to its state at construction,
+  /// scopes nest
+  ///
+  class Scope {
+    BumpArena &m_arena;
+    Mark m_mark;
+
+  public:
+    explicit Scope(BumpArena &arena) : m_arena(arena), m_mark(arena.mark()) {}
+    ~Scope() { m_arena.rewind(m_mark); }
+
+    Scope(const Scope &) = delete;
+    Scope &operator=(const Scope &) = delete;
+  };
+
+  explicit BumpArena(std::size_t chunk_size = 64 * 1024)
+      : m_chunk_size(chunk_size) {}
+
+  BumpArena(const BumpArena &) = delete;
+  BumpArena &operator=(const BumpArena &) = delete;
+
+  /// the arena of the calling thread
+  static BumpArena &local() {
+    static thread_local BumpArena arena;
+    return arena;
+  }
+
+  Mark mark() const { return {m_chunk, m_offset}; }
+  void rewind(Mark mark) {
+    m_chunk = mark.chunk;
+    m_offset = mark.offset;
+  }
+  void reset() { rewind({0, 0}); }
+
+  /// chunks obtained from the heap so far
+  std::size_t chunkCount() const { return m_chunks.size(); }
+
+  /// bytes in use since the last reset, alignment padding included
+  std::size_t used() const {
+    std::size_t bytes = m_offset;
+    for (std::size_t c = 0; c < m_chunk && c < m_chunks.size(); c++) {
+      bytes += m_chunks[c].size;
+    }
+    return bytes;
+  }
+
+protected:
+  void *do_allocate(std::size_t bytes, std::size_t alignment) override {
+    for (;;) {
+      if (m_chunk < m_chunks.size()) {
+        auto &chunk = m_chunks[m_chunk];
+        const auto base = reinterpret_cast<std::uintptr_t>(chunk.data.get());
+        const auto start =
+            ((base + m_offset + alignment - 1) & ~(alignment - 1)) - base;
+        if (start + bytes <= chunk.size) {
+          m_offset = start + bytes;
+          return chunk.data.get() + start;
+        }
+        // the rest of the chunk is lost until the next rewind
+        m_chunk++;
+        m_offset = 0;
+        continue;
+      }
+      const std::size_t size = std::max(m_chunk_size, bytes + alignment);
+      m_chunks.push_back({std::make_unique<std::byte[]>(size), size});
+    }
+  }
+
+  void do_deallocate(void *, std::size_t, std::size_t) override {}
+
+  bool do_is_equal(const std::pmr::memory_resource &other) const
+      noexcept override {
+    return this == &other;
+  }
+
+private:
+  struct Chunk {
+    std::unique_ptr<std::byte[]> data;
+    std::size_t size;
+  };
+
+  std::size_t m_chunk_size;
+  std::vector<Chunk> m_chunks;
+  std::size_t m_chunk{0};  // chunk being filled
+  std::size_t m_offset{0}; // first free byte of that chunk
+};
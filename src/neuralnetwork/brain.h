@@ -0,0 +1,267 @@
+#pragma once
+
+#include "nn.h"
+
+#include <algorithm>
+#include <cstdint>
+#include <random>
+#include <stdexcept>
+#include <utility>
+#include <vector>
+
+///
+/// \brief The Topology struct holds what all brains of a population share:
+/// layer sizes, activation function and learning rate
+///
+/// a brain is parameterCount() doubles laid out as NeuralNetwork::parameters()
+/// weights_ih (hiddens x inputs), weights_ho (outputs x hiddens), bias_h,
+/// bias_o, all row major
+///
+struct Topology {
+  int inputs;
+  int hiddens;
+  int outputs;
+  ActivationFunction activation{NeuralNetwork::sigmoid};
+  double learning_rate{0.1};
+
+  Topology(int inputs, int hiddens, int outputs)
+      : inputs{inputs}, hiddens{hiddens}, outputs{outputs} {}
+
+  std::size_t parameterCount() const {
+    return static_cast<std::size_t>(hiddens) * (inputs + 1) +
+           static_cast<std::size_t>(outputs) * (hiddens + 1);
+  }
+
+  /// same computation as NeuralNetwork::predict, without allocation up to
+  /// 64 hidden nodes, output holds outputs values
+  void predict(const double *params, const double *input,
+               double *output) const {
+    const double *weights_ih = params;
+    const double *weights_ho = weights_ih + hiddens * inputs;
+    const double *bias_h = weights_ho + outputs * hiddens;
+    const double *bias_o = bias_h + hiddens;
+
+    // small enough for the stack, larger layers use the heap
+    double stack[64];
+    std::vector<double> heap;
+    double *hidden = stack;
+    if (hiddens > 64) {
+      heap.resize(hiddens);
+      hidden = heap.data();
+    }
+
+    for (int i = 0; i < hiddens; i++) {
+      double sum = 0;
+      for (int k = 0; k < inputs; k++) {
+        sum += weights_ih[i * inputs + k] * input[k];
+      }
+      hidden[i] = activation.func(sum + bias_h[i]);
+    }
+    for (int i = 0; i < outputs; i++) {
+      double sum = 0;
+      for (int k = 0; k < hiddens; k++) {
+        sum += weights_ho[i * hiddens + k] * hidden[k];
+      }
+      output[i] = activation.func(sum + bias_o[i]);
+    }
+  }
+};
+
+///
+/// \brief The BrainArena class stores the parameters of a population
+/// contiguously, one fixed size slot per brain
+/// slots are reference counted, freed slots are reused
+/// an arena is not thread safe
+///
+class BrainArena {
+  Topology m_topology;
+  std::size_t m_stride;
+  std::vector<double> m_params;
+  std::vector<std::uint32_t> m_refs; // 0 for a free slot
+  std::vector<std::uint32_t> m_free;
+
+public:
+  explicit BrainArena(Topology topology)
+      : m_topology(std::move(topology)),
+        m_stride(m_topology.parameterCount()) {}
+
+  BrainArena(const BrainArena &) = delete;
+  BrainArena &operator=(const BrainArena &) = delete;
+
+  const Topology &topology() const { return m_topology; }
+  std::size_t parameterCount() const { return m_stride; }
+
+  /// slots in use
+  std::size_t size() const { return m_refs.size() - m_free.size(); }
+  std::size_t capacity() const { return m_refs.size(); }
+
+  void reserve(std::size_t brains) {
+    m_params.reserve(brains * m_stride);
+    m_refs.reserve(brains);
+  }
+
+  /// a new slot with one reference, its parameters are unspecified
+  std::uint32_t allocate() {
+    if (!m_free.empty()) {
+      auto slot = m_free.back();
+      m_free.pop_back();
+      m_refs[slot] = 1;
+      return slot;
+    }
+    m_params.resize(m_params.size() + m_stride);
+    m_refs.push_back(1);
+    return static_cast<std::uint32_t>(m_refs.size() - 1);
+  }
+
+  void retain(std::uint32_t slot) { m_refs[slot]++; }
+
+  void release(std::uint32_t slot) {
+    if (--m_refs[slot] == 0) {
+      m_free.push_back(slot);
+    }
+  }
+
+  std::uint32_t references(std::uint32_t slot) const { return m_refs[slot]; }
+
+  double *parameters(std::uint32_t slot) {
+    return m_params.data() + slot * m_stride;
+  }
+  const double *parameters(std::uint32_t slot) const {
+    return m_params.data() + slot * m_stride;
+  }
+};
+
+///
+/// \brief The Brain class is a handle on a slot of a BrainArena
+/// copies share the slot until one of them is mutated (copy on write)
+/// the arena must outlive its brains
+///
+class Brain {
+  BrainArena *m_arena{nullptr};
+  std::uint32_t m_slot{0};
+
+  void reset() {
+    if (m_arena) {
+      m_arena->release(m_slot);
+      m_arena = nullptr;
+    }
+  }
+
+  /// make the slot exclusive before writing to it
+  void detach() {
+    if (m_arena->references(m_slot) > 1) {
+      const auto slot = m_arena->allocate();
+      const double *from = m_arena->parameters(m_slot);
+      std::copy(from, from + m_arena->parameterCount(),
+                m_arena->parameters(slot));
+      m_arena->release(m_slot);
+      m_slot = slot;
+    }
+  }
+
+public:
+  /// an empty brain, it can only be assigned to
+  Brain() = default;
+
+  /// random weights and biases in [0, 1], like NeuralNetwork
+  explicit Brain(BrainArena &arena)
+      : m_arena(&arena), m_slot(arena.allocate()) {
+    std::mt19937 gen(NeuralNetwork::RandomDevice());
+    std::uniform_real_distribution<> distrib(0.0, 1.0);
+    double *params = arena.parameters(m_slot);
+    for (std::size_t k = 0; k < arena.parameterCount(); k++) {
+      params[k] = distrib(gen);
+    }
+  }
+
+  Brain(BrainArena &arena, const NeuralNetwork &network)
+      : m_arena(&arena), m_slot(arena.allocate()) {
+    const auto &topology = arena.topology();
+    if (network.inputNodes() != topology.inputs ||
+        network.hiddenNodes() != topology.hiddens ||
+        network.outputNodes() != topology.outputs) {
+      arena.release(m_slot);
+      throw std::runtime_error("Brain; network does not match the topology");
+    }
+    auto params = network.parameters();
+    std::copy(params.begin(), params.end(), arena.parameters(m_slot));
+  }
+
+  /// a copy of parameterCount() parameters laid out like parameters()
+  Brain(BrainArena &arena, const double *params)
+      : m_arena(&arena), m_slot(arena.allocate()) {
+    std::copy(params, params + arena.parameterCount(),
+              arena.parameters(m_slot));
+  }
+
+  Brain(const Brain &other) : m_arena(other.m_arena), m_slot(other.m_slot) {
+    if (m_arena) {
+      m_arena->retain(m_slot);
+    }
+  }
+
+  Brain(Brain &&other) noexcept
+      : m_arena(std::exchange(other.m_arena, nullptr)), m_slot(other.m_slot) {}
+
+  Brain &operator=(const Brain &other) {
+    Brain copy(other);
+    std::swap(m_arena, copy.m_arena);
+    std::swap(m_slot, copy.m_slot);
+    return *this;
+  }
+
+  Brain &operator=(Brain &&other) noexcept {
+    std::swap(m_arena, other.m_arena);
+    std::swap(m_slot, other.m_slot);
+    return *this;
+  }
+
+  ~Brain() { reset(); }
+
+  bool empty() const { return m_arena == nullptr; }
+  const Topology &topology() const { return m_arena->topology(); }
+  const double *parameters() const { return m_arena->parameters(m_slot); }
+
+  /// same value as toNetwork().hash()
+  std::uint64_t hash() const {
+    const auto &topology = m_arena->topology();
+    return fnv1aParameters(topology.inputs, topology.hiddens, topology.outputs,
+                           parameters(), m_arena->parameterCount());
+  }
+
+  void predict(const double *input, double *output) const {
+    m_arena->topology().predict(parameters(), input, output);
+  }
+
+  std::vector<double> predict(const std::vector<double> &input) const {
+    std::vector<double> output(m_arena->topology().outputs);
+    predict(input.data(), output.data());
+    return output;
+  }
+
+  /// same as NeuralNetwork::mutate: each parameter, with probability rate,
+  /// moves by a gaussian of standard deviation 0.1
+  void mutate(double rate) {
+    static thread_local std::mt19937 gen(NeuralNetwork::RandomDevice());
+    std::uniform_real_distribution<> chance(0.0, 1.0);
+    std::normal_distribution<> offset(0.0, 0.1);
+
+    detach();
+    double *params = m_arena->parameters(m_slot);
+    for (std::size_t k = 0; k < m_arena->parameterCount(); k++) {
+      if (chance(gen) < rate) {
+        params[k] += offset(gen);
+      }
+    }
+  }
+
+  /// a standalone network with the same predictions, to save or train it
+  NeuralNetwork toNetwork() const {
+    const auto &topology = m_arena->topology();
+    NeuralNetwork network(topology.inputs, topology.hiddens, topology.outputs);
+    network.setParameters(parameters());
+    network.setLearningRate(topology.learning_rate);
+    network.setActivationFunction(topology.activation);
+    return network;
+  }
+};
@@ -0,0 +1,130 @@
+#pragma once
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <numeric>
+#include <random>
+#include <stdexcept>
+#include <vector>
+
+///
+/// \brief The EvolutionStrategy class optimizes a flat parameter vector
+/// (OpenAI-ES): the gradient of the expected fitness is estimated from
+/// antithetic gaussian perturbations of the mean, fitnesses are replaced by
+/// their centered ranks, and the mean is updated with Adam
+///
+/// usage: candidates = es.ask(); evaluate them; es.tell(fitnesses);
+///
+class EvolutionStrategy {
+public:
+  struct Config {
+    std::size_t pairs{50};      // population is 2 * pairs
+    double sigma{0.1};          // perturbation standard deviation
+    double learning_rate{0.03}; // Adam step size
+    double beta1{0.9};
+    double beta2{0.999};
+    double epsilon{1e-8};
+  };
+
+  EvolutionStrategy(std::vector<double> mean, std::uint32_t seed)
+      : EvolutionStrategy(std::move(mean), seed, Config{}) {}
+
+  EvolutionStrategy(std::vector<double> mean, std::uint32_t seed,
+                    Config config)
+      : m_config(config), m_mean(std::move(mean)), m_m(m_mean.size(), 0.0),
+        m_v(m_mean.size(), 0.0), m_gen(seed) {}
+
+  const std::vector<double> &mean() const { return m_mean; }
+  std::size_t populationSize() const { return 2 * m_config.pairs; }
+  int generation() const { return m_generation; }
+
+  /// candidates mean + sigma * eps_i and mean - sigma * eps_i interleaved
+  std::vector<std::vector<double>> ask() {
+    const std::size_t dim = m_mean.size();
+    std::normal_distribution<double> normal(0.0, 1.0);
+
+    m_noise.resize(m_config.pairs * dim);
+    for (auto &e : m_noise) {
+      e = normal(m_gen);
+    }
+
+    std::vector<std::vector<double>> candidates(populationSize(),
+                                                m_mean);
+    for (std::size_t p = 0; p < m_config.pairs; p++) {
+      const double *eps = &m_noise[p * dim];
+      for (std::size_t k = 0; k < dim; k++) {
+        candidates[2 * p][k] += m_config.sigma * eps[k];
+        candidates[2 * p + 1][k] -= m_config.sigma * eps[k];
+      }
+    }
+    return candidates;
+  }
+
+  /// fitnesses of the candidates returned by the last ask(), higher is better
+  void tell(const std::vector<double> &fitnesses) {
+    if (fitnesses.size() != populationSize() || m_noise.empty()) {
+      throw std::runtime_error(
+          "EvolutionStrategy::tell; one fitness per candidate of ask().");
+    }
+    const std::size_t dim = m_mean.size();
+    auto ranks = centeredRanks(fitnesses);
+
+    std::vector<double> gradient(dim, 0.0);
+    for (std::size_t p = 0; p < m_config.pairs; p++) {
+      const double weight = ranks[2 * p] - ranks[2 * p + 1];
+      const double *eps = &m_noise[p * dim];
+      for (std::size_t k = 0; k < dim; k++) {
+        gradient[k] += weight * eps[k];
+      }
+    }
+
+    // gradient ascent with Adam
+    m_generation++;
+    const double scale = 1.0 / (populationSize() * m_config.sigma);
+    const double c1 = 1.0 - std::pow(m_config.beta1, m_generation);
+    const double c2 = 1.0 - std::pow(m_config.beta2, m_generation);
+    for (std::size_t k = 0; k < dim; k++) {
+      const double g = gradient[k] * scale;
+      m_m[k] = m_config.beta1 * m_m[k] + (1 - m_config.beta1) * g;
+      m_v[k] = m_config.beta2 * m_v[k] + (1 - m_config.beta2) * g * g;
+      m_mean[k] += m_config.learning_rate * (m_m[k] / c1) /
+                   (std::sqrt(m_v[k] / c2) + m_config.epsilon);
+    }
+    m_noise.clear();
+  }
+
+  /// fitness shaping: ranks mapped to [-0.5, 0.5], ties share their rank
+  static std::vector<double> centeredRanks(const std::vector<double> &x) {
+    std::vector<std::size_t> order(x.size());
+    std::iota(order.begin(), order.end(), 0);
+    std::sort(order.begin(), order.end(),
+              [&x](std::size_t a, std::size_t b) { return x[a] < x[b]; });
+
+    std::vector<double> ranks(x.size(), 0.0);
+    if (x.size() < 2) {
+      return ranks;
+    }
+    for (std::size_t i = 0; i < order.size();) {
+      std::size_t j = i;
+      while (j + 1 < order.size() && x[order[j + 1]] == x[order[i]]) {
+        j++;
+      }
+      const double rank = (i + j) / 2.0 / (x.size() - 1) - 0.5;
+      for (std::size_t k = i; k <= j; k++) {
+        ranks[order[k]] = rank;
+      }
+      i = j + 1;
+    }
+    return ranks;
+  }
+
+private:
+  Config m_config;
+  std::vector<double> m_mean;
+  std::vector<double> m_m; // Adam first moment
+  std::vector<double> m_v; // Adam second moment
+  std::vector<double> m_noise;
+  std::mt19937 m_gen;
+  int m_generation{0};
+};
@@ -0,0 +1,170 @@
+#pragma once
+
+#include <stdexcept>
+#include <string>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+struct Matrix;
+
+///
+/// lazy matrix expressions: the functions of this namespace build
+/// expressions instead of matrices, a chain of element wise operations and
+/// transposes is evaluated in a single loop when it is assigned to a Matrix
+///
+/// Matrix operands are held by reference, other operands by value: an
+/// expression must be assigned before the matrices it refers to go away
+/// products are evaluated element by element, their operands should be
+/// matrices or transposed matrices, not costly expressions
+///
+namespace mx {
+
+template <typename E> struct Expr {
+  const E &self() const { return static_cast<const E &>(*this); }
+  int rowCount() const { return self().rowCount(); }
+  int colCount() const { return self().colCount(); }
+  double operator()(int i, int j) const { return self()(i, j); }
+};
+
+// matrices are stored by reference, expressions by value
+template <typename E>
+using Operand =
+    std::conditional_t<std::is_same_v<E, Matrix>, const Matrix &, E>;
+
+inline void checkSameShape(int rows_a, int cols_a, int rows_b, int cols_b,
+                           const char *operation) {
+  if (rows_a != rows_b || cols_a != cols_b) {
+    throw std::runtime_error(std::string("mx::") + operation +
+                             "; Columns and Rows of A must match Columns and "
+                             "Rows of B.");
+  }
+}
+
+/// a vector seen as a column matrix, like Matrix::fromArray
+struct Column : Expr<Column> {
+  const std::vector<double> &values;
+
+  explicit Column(const std::vector<double> &values) : values(values) {}
+  int rowCount() const { return static_cast<int>(values.size()); }
+  int colCount() const { return 1; }
+  double operator()(int i, int) const { return values[i]; }
+};
+
+template <typename A, typename B, typename Op>
+struct ElementWise : Expr<ElementWise<A, B, Op>> {
+  Operand<A> a;
+  Operand<B> b;
+  Op op;
+
+  ElementWise(const A &a, const B &b, Op op, const char *name)
+      : a(a), b(b), op(op) {
+    checkSameShape(a.rowCount(), a.colCount(), b.rowCount(), b.colCount(),
+                   name);
+  }
+  int rowCount() const { return a.rowCount(); }
+  int colCount() const { return a.colCount(); }
+  double operator()(int i, int j) const { return op(a(i, j), b(i, j)); }
+};
+
+template <typename A, typename F> struct Map : Expr<Map<A, F>> {
+  Operand<A> a;
+  F f;
+
+  Map(const A &a, F f) : a(a), f(std::move(f)) {}
+  int rowCount() const { return a.rowCount(); }
+  int colCount() const { return a.colCount(); }
+  double operator()(int i, int j) const { return f(a(i, j)); }
+};
+
+template <typename A> struct Transpose : Expr<Transpose<A>> {
+  Operand<A> a;
+
+  explicit Transpose(const A &a) : a(a) {}
+  int rowCount() const { return a.colCount(); }
+  int colCount() const { return a.rowCount(); }
+  double operator()(int i, int j) const { return a(j, i); }
+};
+
+template <typename A, typename B> struct Product : Expr<Product<A, B>> {
+  Operand<A> a;
+  Operand<B> b;
+
+  Product(const A &a, const B &b) : a(a), b(b) {
+    if (a.colCount() != b.rowCount()) {
+      throw std::runtime_error(
+          "mx::product; Columns of A must match rows of B.");
+    }
+  }
+  int rowCount() const { return a.rowCount(); }
+  int colCount() const { return b.colCount(); }
+  double operator()(int i, int j) const {
+    // same summation order as Matrix::multiply
+    double sum = 0;
+    for (int k = 0; k < a.colCount(); k++) {
+      sum += a(i, k) * b(k, j);
+    }
+    return sum;
+  }
+};
+
+struct Plus {
+  double operator()(double a, double b) const { return a + b; }
+};
+struct Minus {
+  double operator()(double a, double b) const { return a - b; }
+};
+struct Times {
+  double operator()(double a, double b) const { return a * b; }
+};
+
+template <typename A> struct Scale : Expr<Scale<A>> {
+  Operand<A> a;
+  double n;
+
+  Scale(const A &a, double n) : a(a), n(n) {}
+  int rowCount() const { return a.rowCount(); }
+  int colCount() const { return a.colCount(); }
+  double operator()(int i, int j) const { return a(i, j) * n; }
+};
+
+inline Column column(const std::vector<double> &values) {
+  return Column(values);
+}
+
+template <typename A, typename B>
+ElementWise<A, B, Plus> operator+(const Expr<A> &a, const Expr<B> &b) {
+  return {a.self(), b.self(), Plus{}, "add"};
+}
+
+template <typename A, typename B>
+ElementWise<A, B, Minus> operator-(const Expr<A> &a, const Expr<B> &b) {
+  return {a.self(), b.self(), Minus{}, "subtract"};
+}
+
+/// element wise product
+template <typename A, typename B>
+ElementWise<A, B, Times> hadamard(const Expr<A> &a, const Expr<B> &b) {
+  return {a.self(), b.self(), Times{}, "hadamard"};
+}
+
+/// scalar product
+template <typename A> Scale<A> operator*(const Expr<A> &a, double n) {
+  return {a.self(), n};
+}
+
+template <typename A, typename F> Map<A, F> map(const Expr<A> &a, F f) {
+  return {a.self(), std::move(f)};
+}
+
+template <typename A> Transpose<A> transpose(const Expr<A> &a) {
+  return Transpose<A>(a.self());
+}
+
+/// matrix product
+template <typename A, typename B>
+Product<A, B> product(const Expr<A> &a, const Expr<B> &b) {
+  return {a.self(), b.self()};
+}
+
+} // namespace mx
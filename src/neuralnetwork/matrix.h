@@ -1,24 +1,79 @@
 #pragma once
+#include "expr.h"
+
 #include <functional>
+#include <memory_resource>
 #ifdef JSON_SERIALIZATION
 #include <nlohmann/json.hpp>
 #endif
 #include <random>
 #include <vector>
 
-struct Matrix {
+struct Matrix : mx::Expr<Matrix> {
+
+  using Row = std::pmr::vector<double>;
 
   int rows;
   int cols;
-  std::vector<std::vector<double>> data;
+  std::pmr::vector<Row> data;
   static std::random_device RandomDevice;
 
-  Matrix(int rows, int cols)
-      : rows{rows}, cols{cols}, data(rows, std::vector<double>(cols, 0.0)) {}
+  /// storage comes from resource, e.g. a BumpArena for temporaries
+  /// copies use the default resource
+  Matrix(int rows, int cols,
+         std::pmr::memory_resource *resource = std::pmr::get_default_resource())
+      : rows{rows}, cols{cols}, data(rows, resource) {
+    for (auto &row : data) {
+      row.resize(cols, 0.0);
+    }
+  }
+
+  /// evaluates a lazy expression in one loop
+  template <typename E>
+  Matrix(const mx::Expr<E> &e,
+         std::pmr::memory_resource *resource = std::pmr::get_default_resource())
+      : Matrix(e.rowCount(), e.colCount(), resource) {
+    assign(e);
+  }
+
+  Matrix(const Matrix &) = default;
+  Matrix(Matrix &&) = default;
+  Matrix &operator=(const Matrix &) = default;
+  Matrix &operator=(Matrix &&) = default;
+
+  /// the expression must not read this matrix at other positions than the
+  /// one being written (no m = mx::transpose(m))
+  template <typename E> Matrix &operator=(const mx::Expr<E> &e) {
+    if (rows != e.rowCount() || cols != e.colCount()) {
+      *this = Matrix(e, resource());
+      return *this;
+    }
+    return assign(e);
+  }
+
+  template <typename E> Matrix &operator+=(const mx::Expr<E> &e) {
+    mx::checkSameShape(rows, cols, e.rowCount(), e.colCount(), "add");
+    for (int i = 0; i < rows; i++) {
+      auto &row = data[i];
+      for (int j = 0; j < cols; j++) {
+        row[j] += e(i, j);
+      }
+    }
+    return *this;
+  }
+
+  std::pmr::memory_resource *resource() const {
+    return data.get_allocator().resource();
+  }
+
+  // expression interface
+  int rowCount() const { return rows; }
+  int colCount() const { return cols; }
+  double operator()(int i, int j) const { return data[i][j]; }
 
   static Matrix fromArray(const std::vector<double> &array) {
     Matrix m{1, static_cast<int>(array.size())};
-    m.data[0] = array;
+    m.data[0].assign(array.begin(), array.end());
 
     return Matrix::transpose(m);
   }
@@ -191,10 +246,24 @@ struct Matrix {
     int cols = j["cols"];
     int rows = j["rows"];
     Matrix m{rows, cols};
-    m.data = j["data"].get<std::vector<std::vector<double>>>();
+    auto rows_data = j["data"].get<std::vector<std::vector<double>>>();
+    for (std::size_t i = 0; i < rows_data.size() && i < m.data.size(); i++) {
+      m.data[i].assign(rows_data[i].begin(), rows_data[i].end());
+    }
     return m;
   }
 #endif
+
+private:
+  template <typename E> Matrix &assign(const mx::Expr<E> &e) {
+    for (int i = 0; i < rows; i++) {
+      auto &row = data[i];
+      for (int j = 0; j < cols; j++) {
+        row[j] = e(i, j);
+      }
+    }
+    return *this;
+  }
 };
 
 #include <iomanip> // std::setw
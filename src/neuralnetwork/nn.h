@@ -1,8 +1,14 @@
 #pragma once
+#include <algorithm>
 #include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
 #include <fstream>
 #include <functional>
+#include <memory>
 
+#include "arena.h"
 #include "matrix.h"
 
 #ifdef JSON_SERIALIZATION
@@ -18,6 +24,30 @@ struct ActivationFunction {
       : func(func), dfunc(dfunc) {}
 };
 
+///
+/// \brief fnv1aParameters is the FNV-1a hash of a topology and of the bits
+/// of its count parameters, shared by NeuralNetwork::hash and Brain::hash
+///
+inline std::uint64_t fnv1aParameters(int inputs, int hiddens, int outputs,
+                                     const double *params, std::size_t count) {
+  std::uint64_t h = 14695981039346656037ull;
+  auto mix = [&h](std::uint64_t word) {
+    for (int byte = 0; byte < 8; byte++) {
+      h ^= (word >> (8 * byte)) & 0xff;
+      h *= 1099511628211ull;
+    }
+  };
+  mix(static_cast<std::uint64_t>(inputs));
+  mix(static_cast<std::uint64_t>(hiddens));
+  mix(static_cast<std::uint64_t>(outputs));
+  for (std::size_t k = 0; k < count; k++) {
+    std::uint64_t bits;
+    std::memcpy(&bits, &params[k], sizeof(bits));
+    mix(bits);
+  }
+  return h;
+}
+
 class NeuralNetwork {
 
   int input_nodes;
@@ -77,21 +107,32 @@ public:
 #endif
 
   std::vector<double> predict(const std::vector<double> &input_array) const {
+    std::vector<double> output;
+    predict(input_array, output);
+    return output;
+  }
 
-    // Generating the Hidden Outputs
-    auto inputs = Matrix::fromArray(input_array);
-    auto hidden = Matrix::multiply(weights_ih, inputs);
-    hidden.add(this->bias_h);
-    // activation function!
-    hidden.map(this->activation_function.func);
+  /// predict into output, which keeps its capacity between calls
+  void predict(const std::vector<double> &input_array,
+               std::vector<double> &output_array) const {
+    using namespace mx;
+    auto func = std::cref(this->activation_function.func);
+    // temporaries live in the thread arena until the end of the call
+    auto &arena = BumpArena::local();
+    BumpArena::Scope scope(arena);
+
+    // Generating the Hidden Outputs, with activation function
+    Matrix hidden(
+        map(product(weights_ih, column(input_array)) + bias_h, func), &arena);
 
     // Generating the output's output!
-    auto output = Matrix::multiply(this->weights_ho, hidden);
-    output.add(this->bias_o);
-    output.map(this->activation_function.func);
+    Matrix output(map(product(weights_ho, hidden) + bias_o, func), &arena);
 
     // Sending back to the caller!
-    return output.toArray();
+    output_array.resize(output_nodes);
+    for (int i = 0; i < output_nodes; i++) {
+      output_array[i] = output.data[i][0];
+    }
   }
 
   void setLearningRate(double learning_rate) {
@@ -104,63 +145,54 @@ public:
 
   void train(const std::vector<double> &input_array,
              const std::vector<double> &target_array) {
+    // expressions are evaluated once assigned to a Matrix, element wise
+    // chains and transposes do not create temporaries
+    using namespace mx;
+    auto func = std::cref(this->activation_function.func);
+    auto dfunc = std::cref(this->activation_function.dfunc);
+    auto inputs = column(input_array);
+    // temporaries live in the thread arena until the end of the call
+    auto &arena = BumpArena::local();
+    BumpArena::Scope scope(arena);
+
     // Generating the Hidden Outputs
-    auto inputs = Matrix::fromArray(input_array);
-    auto hidden = Matrix::multiply(this->weights_ih, inputs);
-    hidden.add(this->bias_h);
-    // activation function!
-    hidden.map(this->activation_function.func);
+    Matrix hidden(map(product(weights_ih, inputs) + bias_h, func), &arena);
 
     // Generating the output's output!
-    auto outputs = Matrix::multiply(this->weights_ho, hidden);
-    outputs.add(this->bias_o);
-    outputs.map(this->activation_function.func);
-
-    // Convert array to matrix object
-    auto targets = Matrix::fromArray(target_array);
+    Matrix outputs(map(product(weights_ho, hidden) + bias_o, func), &arena);
 
     // Calculate the error
     // ERROR = TARGETS - OUTPUTS
-    auto output_errors = Matrix::subtract(targets, outputs);
+    Matrix output_errors(column(target_array) - outputs, &arena);
 
-    // auto gradient = outputs * (1 - outputs);
     // Calculate gradient
-    auto gradients = Matrix::map(outputs, this->activation_function.dfunc);
-    gradients.multiply(output_errors);
-    gradients.multiply(this->learning_rate);
-
-    // Calculate deltas
-    auto hidden_T = Matrix::transpose(hidden);
-    auto weight_ho_deltas = Matrix::multiply(gradients, hidden_T);
+    // gradient = outputs * (1 - outputs) * error * learning rate
+    Matrix gradients(
+        hadamard(map(outputs, dfunc), output_errors) * this->learning_rate,
+        &arena);
 
     // Adjust the weights by deltas
-    this->weights_ho.add(weight_ho_deltas);
+    this->weights_ho += product(gradients, transpose(hidden));
     // Adjust the bias by its deltas (which is just the gradients)
-    this->bias_o.add(gradients);
+    this->bias_o += gradients;
 
     // Calculate the hidden layer errors
-    auto who_t = Matrix::transpose(this->weights_ho);
-    auto hidden_errors = Matrix::multiply(who_t, output_errors);
+    Matrix hidden_errors(product(transpose(this->weights_ho), output_errors),
+                         &arena);
 
     // Calculate hidden gradient
-    auto hidden_gradient = Matrix::map(hidden, this->activation_function.dfunc);
-    hidden_gradient.multiply(hidden_errors);
-    hidden_gradient.multiply(this->learning_rate);
-
-    // Calcuate input->hidden deltas
-    auto inputs_T = Matrix::transpose(inputs);
-    auto weight_ih_deltas = Matrix::multiply(hidden_gradient, inputs_T);
+    Matrix hidden_gradient(
+        hadamard(map(hidden, dfunc), hidden_errors) * this->learning_rate,
+        &arena);
 
-    this->weights_ih.add(weight_ih_deltas);
+    // Adjust the weights by input->hidden deltas
+    this->weights_ih += product(hidden_gradient, transpose(inputs));
     // Adjust the bias by its deltas (which is just the gradients)
-    this->bias_h.add(hidden_gradient);
-
-    // outputs.print();
-    // targets.print();
-    // error.print();
+    this->bias_h += hidden_gradient;
   }
 #ifdef JSON_SERIALIZATION
-  std::string serialise() const {
+  /// indent < 0 gives the compact form
+  std::string serialise(int indent = 4) const {
     nlohmann::json j;
 
     j["input_nodes"] = input_nodes;
@@ -172,7 +204,7 @@ public:
     j["bias_o"] = bias_o.serialise();
     j["learning_rate"] = learning_rate;
 
-    return j.dump(4);
+    return j.dump(indent);
   }
 
   static NeuralNetwork deserialise(std::string data) {
@@ -188,8 +220,61 @@ public:
     nn.learning_rate = j["learning_rate"];
     return nn;
   }
+
+  ///
+  /// \brief load streams a saved network into this one, weights are written
+  /// in place as they are parsed, without building a json document
+  /// the saved network must have the same topology, on error the network is
+  /// left partially loaded
+  ///
+  void load(const std::string &filename);
 #endif
 
+  /// number of weights and biases
+  std::size_t parameterCount() const {
+    return static_cast<std::size_t>(hidden_nodes) * (input_nodes + 1) +
+           static_cast<std::size_t>(output_nodes) * (hidden_nodes + 1);
+  }
+
+  /// all weights and biases flattened row by row in the order
+  /// weights_ih, weights_ho, bias_h, bias_o
+  std::vector<double> parameters() const {
+    std::vector<double> params;
+    params.reserve(parameterCount());
+    for (auto m : {&weights_ih, &weights_ho, &bias_h, &bias_o}) {
+      m->forEach([&params](double val) { params.push_back(val); });
+    }
+    return params;
+  }
+
+  void setParameters(const std::vector<double> &params) {
+    if (params.size() != parameterCount()) {
+      throw std::runtime_error("NeuralNetwork::setParameters; size must match "
+                               "parameterCount().");
+    }
+    setParameters(params.data());
+  }
+
+  /// reads parameterCount() values laid out as parameters()
+  void setParameters(const double *params) {
+    for (auto m : {&weights_ih, &weights_ho, &bias_h, &bias_o}) {
+      m->forEach([&params](double &val) { val = *params++; });
+    }
+  }
+
+  /// FNV-1a hash of the topology and of the bits of every weight and bias,
+  /// networks with the same hash make the same predictions (as long as they
+  /// share their activation function)
+  std::uint64_t hash() const {
+    const auto params = parameters();
+    return fnv1aParameters(input_nodes, hidden_nodes, output_nodes,
+                           params.data(), params.size());
+  }
+
+  int inputNodes() const { return input_nodes; }
+  int hiddenNodes() const { return hidden_nodes; }
+  int outputNodes() const { return output_nodes; }
+
   void mutate(double rate) {
 
     auto mutate = [rate](double val) {
@@ -214,13 +299,19 @@ public:
     this->bias_o.map(mutate);
   }
 
-  void save(std::string filename) const;
+  /// compact files are smaller and faster to load
+  void save(std::string filename, bool compact = false) const;
 
   static const ActivationFunction sigmoid;
 
   static const ActivationFunction tanh;
 
   static std::random_device RandomDevice;
+
+private:
+#ifdef JSON_SERIALIZATION
+  class JsonLoader;
+#endif
 };
 
 const ActivationFunction
@@ -240,8 +331,198 @@ std::ostream &operator<<(std::ostream &out, const NeuralNetwork &nn) {
   return out;
 }
 
-void NeuralNetwork::save(std::string filename) const {
+void NeuralNetwork::save(std::string filename, bool compact) const {
   std::ofstream f(filename);
-  f << *this;
+  f << serialise(compact ? -1 : 4) << '\n';
+}
+
+///
+/// \brief The JsonLoader class is the SAX handler of NeuralNetwork::load
+/// numbers of the "data" arrays go straight into the matrices, the other
+/// values are checked against the network, unknown keys are skipped
+///
+class NeuralNetwork::JsonLoader {
+  enum class Field { Skip, Matrix, InputNodes, HiddenNodes, OutputNodes, Rate };
+  enum class MatrixKey { Skip, Rows, Cols, Data };
+
+  NeuralNetwork &nn;
+  int depth{0}; // objects and arrays opened
+  Field field{Field::Skip};
+  MatrixKey matrix_key{MatrixKey::Skip};
+  Matrix *matrix{nullptr};
+  int row{0};
+  int col{0};
+  std::size_t loaded[4]{};
+  std::string m_error;
+
+  int index() const {
+    const Matrix *matrices[] = {&nn.weights_ih, &nn.weights_ho, &nn.bias_h,
+                                &nn.bias_o};
+    return static_cast<int>(std::find(matrices, matrices + 4, matrix) -
+                            matrices);
+  }
+
+  bool fail(const std::string &message) {
+    m_error = message;
+    return false;
+  }
+
+  bool value(double v) {
+    if (depth == 1) {
+      switch (field) {
+      case Field::InputNodes:
+        return v == nn.input_nodes || fail("input_nodes do not match");
+      case Field::HiddenNodes:
+        return v == nn.hidden_nodes || fail("hidden_nodes do not match");
+      case Field::OutputNodes:
+        return v == nn.output_nodes || fail("output_nodes do not match");
+      case Field::Rate:
+        nn.learning_rate = v;
+        return true;
+      case Field::Matrix:
+        return fail("a matrix is expected");
+      case Field::Skip:
+        return true;
+      }
+    }
+    if (field != Field::Matrix) {
+      return true;
+    }
+    if (depth == 2 && matrix_key == MatrixKey::Rows) {
+      return v == matrix->rows || fail("matrix rows do not match");
+    }
+    if (depth == 2 && matrix_key == MatrixKey::Cols) {
+      return v == matrix->cols || fail("matrix cols do not match");
+    }
+    if (matrix_key == MatrixKey::Data) {
+      if (depth != 4 || row >= matrix->rows || col >= matrix->cols) {
+        return fail("matrix data does not match its size");
+      }
+      matrix->data[row][col++] = v;
+      loaded[index()]++;
+    }
+    return true;
+  }
+
+public:
+  explicit JsonLoader(NeuralNetwork &nn) : nn(nn) {}
+
+  const std::string &error() const { return m_error; }
+
+  /// every matrix was entirely loaded
+  bool complete() const {
+    const Matrix *matrices[] = {&nn.weights_ih, &nn.weights_ho, &nn.bias_h,
+                                &nn.bias_o};
+    for (int m = 0; m < 4; m++) {
+      if (loaded[m] !=
+          static_cast<std::size_t>(matrices[m]->rows * matrices[m]->cols)) {
+        return false;
+      }
+    }
+    return true;
+  }
+
+  // SAX interface
+  bool null() { return depth > 1 || field == Field::Skip || fail("null"); }
+  bool boolean(bool) {
+    return depth > 1 || field == Field::Skip || fail("unexpected boolean");
+  }
+  bool number_integer(std::int64_t v) { return value(static_cast<double>(v)); }
+  bool number_unsigned(std::uint64_t v) {
+    return value(static_cast<double>(v));
+  }
+  bool number_float(double v, const std::string &) { return value(v); }
+  bool string(std::string &) {
+    return depth > 1 || field == Field::Skip || fail("unexpected string");
+  }
+  template <typename Binary> bool binary(Binary &) {
+    return fail("unexpected binary");
+  }
+
+  bool start_object(std::size_t) {
+    depth++;
+    if (depth == 2 && field != Field::Matrix && field != Field::Skip) {
+      return fail("a number is expected");
+    }
+    return true;
+  }
+  bool end_object() {
+    depth--;
+    return true;
+  }
+
+  bool key(std::string &key) {
+    if (depth == 1) {
+      field = Field::Skip;
+      matrix = nullptr;
+      if (key == "input_nodes") {
+        field = Field::InputNodes;
+      } else if (key == "hidden_nodes") {
+        field = Field::HiddenNodes;
+      } else if (key == "output_nodes") {
+        field = Field::OutputNodes;
+      } else if (key == "learning_rate") {
+        field = Field::Rate;
+      } else if (key == "weights_ih") {
+        matrix = &nn.weights_ih;
+      } else if (key == "weights_ho") {
+        matrix = &nn.weights_ho;
+      } else if (key == "bias_h") {
+        matrix = &nn.bias_h;
+      } else if (key == "bias_o") {
+        matrix = &nn.bias_o;
+      }
+      if (matrix) {
+        field = Field::Matrix;
+      }
+    } else if (depth == 2 && field == Field::Matrix) {
+      matrix_key = key == "rows"   ? MatrixKey::Rows
+                   : key == "cols" ? MatrixKey::Cols
+                   : key == "data" ? MatrixKey::Data
+                                   : MatrixKey::Skip;
+    }
+    return true;
+  }
+
+  bool start_array(std::size_t) {
+    depth++;
+    if (field == Field::Matrix && matrix_key == MatrixKey::Data) {
+      if (depth == 3) {
+        row = -1;
+      } else if (depth == 4) {
+        row++;
+        col = 0;
+      }
+    }
+    return true;
+  }
+  bool end_array() {
+    if (field == Field::Matrix && matrix_key == MatrixKey::Data &&
+        depth == 4 && col != matrix->cols) {
+      return fail("matrix data does not match its size");
+    }
+    depth--;
+    return true;
+  }
+
+  template <typename Exception>
+  bool parse_error(std::size_t, const std::string &, const Exception &e) {
+    return fail(e.what());
+  }
+};
+
+inline void NeuralNetwork::load(const std::string &filename) {
+  std::unique_ptr<std::FILE, int (*)(std::FILE *)> file(
+      std::fopen(filename.c_str(), "rb"), &std::fclose);
+  if (!file) {
+    throw std::runtime_error("NeuralNetwork::load; can not open " + filename);
+  }
+
+  JsonLoader loader(*this);
+  if (!nlohmann::json::sax_parse(file.get(), &loader) || !loader.complete()) {
+    throw std::runtime_error(
+        "NeuralNetwork::load; " + filename + ": " +
+        (loader.error().empty() ? "missing weights" : loader.error()));
+  }
 }
 #endif
\ No newline at end of file
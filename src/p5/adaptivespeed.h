@@ -0,0 +1,83 @@
+#pragma once
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+
+///
+/// \brief The AdaptiveSpeed class chooses how many simulation ticks run in a
+/// frame so that simulation and rendering fit in a target frame time
+/// when rendering alone is too expensive, only one frame out of n is rendered
+///
+class AdaptiveSpeed {
+  using Clock = std::chrono::steady_clock;
+
+  double m_target_ms;
+  double m_tick_ms{0.05};  // smoothed cost of one tick
+  double m_render_ms{1.0}; // smoothed cost of one render
+  int m_ticks{1};
+  int m_render_period{1}; // render one frame out of m_render_period
+  int m_frame{0};
+
+  Clock::time_point m_window_start{Clock::now()};
+  long m_window_ticks{0};
+  double m_ticks_per_second{0};
+
+  static constexpr double Smoothing = 0.2;
+  // rendering may use at most this share of the budget, averaged over frames
+  static constexpr double RenderShare = 0.5;
+  static constexpr int MaxTicks = 100000;
+
+public:
+  explicit AdaptiveSpeed(double target_ms) : m_target_ms(target_ms) {}
+
+  /// ticks to run in the current frame
+  int ticks() const { return m_ticks; }
+
+  /// true when the current frame has to be rendered
+  bool render() const { return m_frame % m_render_period == 0; }
+
+  /// report the cost of the current frame and prepare the next one
+  /// render_ms is ignored when the frame was not rendered
+  void frame(int ticks, double simulation_ms, double render_ms) {
+    if (ticks > 0) {
+      smooth(m_tick_ms, simulation_ms / ticks);
+    }
+    if (render()) {
+      smooth(m_render_ms, render_ms);
+    }
+
+    m_render_period = std::max(
+        1, static_cast<int>(std::ceil(m_render_ms / (RenderShare * m_target_ms))));
+    m_frame = (m_frame + 1) % m_render_period;
+
+    // frames without render use the whole budget for the simulation
+    const double render_cost = render() ? m_render_ms : 0.0;
+    const double budget = std::max(m_target_ms - render_cost, 0.0);
+    const int wanted = static_cast<int>(budget / std::max(m_tick_ms, 1e-6));
+
+    // at most double per frame, to stay stable after a slow frame
+    m_ticks = std::clamp(wanted, 1, std::min(2 * m_ticks, MaxTicks));
+
+    m_window_ticks += ticks;
+    const auto now = Clock::now();
+    const double elapsed =
+        std::chrono::duration<double>(now - m_window_start).count();
+    if (elapsed >= 1.0) {
+      m_ticks_per_second = m_window_ticks / elapsed;
+      m_window_ticks = 0;
+      m_window_start = now;
+    }
+  }
+
+  /// achieved simulation speed, updated every second
+  double ticksPerSecond() const { return m_ticks_per_second; }
+
+  double tickCost() const { return m_tick_ms; }
+  double renderCost() const { return m_render_ms; }
+
+private:
+  static void smooth(double &average, double value) {
+    average += Smoothing * (value - average);
+  }
+};
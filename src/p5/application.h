@@ -1,6 +1,18 @@
 #pragma once
 
 #include <stdexcept>
+#include <string>
+#include <vector>
+
+///
+/// \brief The Rect struct describes a rectangle in canvas coordinates
+///
+struct Rect {
+  int x;
+  int y;
+  int w;
+  int h;
+};
 
 ///
 /// \brief The Canvas struct is minimale interface to a canvas
@@ -29,6 +41,8 @@ struct Canvas {
 
   virtual void line(int x1, int y1, int x2, int y2) = 0;
   virtual void rect(int x1, int y1, int w, int h) = 0;
+  /// draw all rects with the current fill and stroke state in one call
+  virtual void rects(const std::vector<Rect> &rects) = 0;
 
   virtual void text(std::string str, int x, int y) = 0;
 
@@ -45,6 +59,17 @@ struct Canvas {
 
   virtual char key() const = 0;
 
+  ///
+  /// partial repaint: frames are painted over a retained copy of the previous
+  /// one, only when redraw() asked for it, and clipped to the redrawn areas
+  /// canvases without a retained frame ignore it and repaint everything
+  ///
+  virtual void partialRepaint(bool enabled) {}
+  /// repaint area at the next frame
+  virtual void redraw(const Rect &area) {}
+  /// true when the current frame must paint the whole canvas
+  virtual bool fullRedraw() const { return true; }
+
 protected:
   virtual bool isDrawing() const = 0;
   void ThrowIfNotDrawing() {
@@ -123,11 +148,24 @@ void keyPressed(Canvas &) __attribute__((weak));
 #define P5_BACKEND_QT()                                                        \
                                                                                \
   int main(int argc, char *argv[]) {                                           \
-    QApplication a(argc, argv);                                                \
     Application p5_app;                                                        \
     p5_app.Register(setup, draw);                                              \
     p5_app.RegisterMousePressed(mousePressed);                                 \
     p5_app.RegisterKeyPressed(keyPressed);                                     \
+    std::optional<OffscreenOptions> options;                                   \
+    try {                                                                      \
+      options = OffscreenOptions::parse(argc, argv);                           \
+    } catch (const std::exception &e) {                                        \
+      std::cerr << argv[0] << ": " << e.what() << "\nusage: " << argv[0]       \
+                << " [" << OffscreenOptions::Usage << "]\n";                   \
+      return 2;                                                                \
+    }                                                                          \
+    if (options) {                                                             \
+      qputenv("QT_QPA_PLATFORM", "offscreen");                                 \
+      QGuiApplication a(argc, argv);                                           \
+      return runOffscreen(p5_app, *options);                                   \
+    }                                                                          \
+    QApplication a(argc, argv);                                                \
     QtCanvas canvas(&p5_app);                                                  \
     canvas.show();                                                             \
     canvas.setFramerate(30);                                                   \
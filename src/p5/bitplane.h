@@ -0,0 +1,218 @@
+#pragma once
+#include "grid.h"
+
+#include <algorithm>
+#include <array>
+#include <cstdint>
+#include <stdexcept>
+#include <vector>
+
+inline int popcount(std::uint64_t word) {
+#if defined(__GNUC__)
+  return __builtin_popcountll(word);
+#else
+  int count = 0;
+  for (; word; word &= word - 1) {
+    count++;
+  }
+  return count;
+#endif
+}
+
+///
+/// \brief The BitPlane class is one boolean per cell, packed 64 to a word
+/// bits past size() are always 0, so whole plane operations work word by
+/// word
+///
+class BitPlane {
+  std::size_t m_size{0};
+  std::vector<std::uint64_t> m_words;
+
+  void clearTail() {
+    if (m_size % 64) {
+      m_words.back() &= (std::uint64_t{1} << (m_size % 64)) - 1;
+    }
+  }
+
+public:
+  BitPlane() = default;
+  explicit BitPlane(std::size_t size, bool value = false)
+      : m_size(size),
+        m_words((size + 63) / 64, value ? ~std::uint64_t{0} : 0) {
+    clearTail();
+  }
+
+  std::size_t size() const { return m_size; }
+
+  bool test(std::size_t i) const { return (m_words[i / 64] >> (i % 64)) & 1; }
+  void set(std::size_t i, bool value = true) {
+    const std::uint64_t bit = std::uint64_t{1} << (i % 64);
+    m_words[i / 64] = value ? m_words[i / 64] | bit : m_words[i / 64] & ~bit;
+  }
+  void reset(std::size_t i) { set(i, false); }
+  void flip(std::size_t i) { m_words[i / 64] ^= std::uint64_t{1} << (i % 64); }
+
+  void fill(bool value) {
+    std::fill(m_words.begin(), m_words.end(), value ? ~std::uint64_t{0} : 0);
+    clearTail();
+  }
+
+  /// number of bits set
+  std::size_t count() const {
+    std::size_t n = 0;
+    for (auto word : m_words) {
+      n += popcount(word);
+    }
+    return n;
+  }
+
+  bool any() const {
+    for (auto word : m_words) {
+      if (word) {
+        return true;
+      }
+    }
+    return false;
+  }
+
+  BitPlane &operator|=(const BitPlane &other) {
+    checkSize(other);
+    for (std::size_t w = 0; w < m_words.size(); w++) {
+      m_words[w] |= other.m_words[w];
+    }
+    return *this;
+  }
+
+  BitPlane &operator&=(const BitPlane &other) {
+    checkSize(other);
+    for (std::size_t w = 0; w < m_words.size(); w++) {
+      m_words[w] &= other.m_words[w];
+    }
+    return *this;
+  }
+
+  /// clear the bits set in other
+  BitPlane &clear(const BitPlane &other) {
+    checkSize(other);
+    for (std::size_t w = 0; w < m_words.size(); w++) {
+      m_words[w] &= ~other.m_words[w];
+    }
+    return *this;
+  }
+
+  /// raw words, bit i of the plane is bit i % 64 of word i / 64
+  const std::vector<std::uint64_t> &words() const { return m_words; }
+  std::uint64_t *data() { return m_words.data(); }
+
+  std::size_t bytes() const { return m_words.size() * sizeof(std::uint64_t); }
+
+private:
+  void checkSize(const BitPlane &other) const {
+    if (other.m_size != m_size) {
+      throw std::runtime_error("BitPlane; planes of different sizes");
+    }
+  }
+};
+
+///
+/// \brief The NibblePlane class is a count from 0 to 15 per cell, packed 16
+/// to a word
+///
+class NibblePlane {
+  std::size_t m_size{0};
+  std::vector<std::uint64_t> m_words;
+
+public:
+  NibblePlane() = default;
+  explicit NibblePlane(std::size_t size)
+      : m_size(size), m_words((size + 15) / 16, 0) {}
+
+  std::size_t size() const { return m_size; }
+
+  int get(std::size_t i) const {
+    return static_cast<int>((m_words[i / 16] >> (4 * (i % 16))) & 0xf);
+  }
+  void set(std::size_t i, int value) {
+    const int shift = 4 * (i % 16);
+    auto &word = m_words[i / 16];
+    word = (word & ~(std::uint64_t{0xf} << shift)) |
+           (static_cast<std::uint64_t>(value & 0xf) << shift);
+  }
+
+  void fill(int value) {
+    std::uint64_t word = 0;
+    for (int n = 0; n < 16; n++) {
+      word = word << 4 | static_cast<std::uint64_t>(value & 0xf);
+    }
+    std::fill(m_words.begin(), m_words.end(), word);
+  }
+
+  const std::vector<std::uint64_t> &words() const { return m_words; }
+  std::uint64_t *data() { return m_words.data(); }
+
+  std::size_t bytes() const { return m_words.size() * sizeof(std::uint64_t); }
+};
+
+///
+/// \brief The PlanarGrid class is a Grid storage where each attribute of the
+/// cells is a plane of its own: Flags bit planes and Counts nibble planes
+/// cells are indexed like Grid, column after column
+///
+/// an operation touching one attribute reads only that plane, whole board
+/// queries such as counting revealed cells run word by word
+///
+template <std::size_t Flags, std::size_t Counts = 0> class PlanarGrid {
+  Size m_size;
+  std::array<BitPlane, Flags> m_flags;
+  std::array<NibblePlane, Counts> m_counts;
+
+public:
+  explicit PlanarGrid(Size size) : m_size(size) {
+    for (auto &plane : m_flags) {
+      plane = BitPlane(cellCount());
+    }
+    for (auto &plane : m_counts) {
+      plane = NibblePlane(cellCount());
+    }
+  }
+
+  Size size() const { return m_size; }
+  std::size_t cellCount() const {
+    return static_cast<std::size_t>(m_size.row) * m_size.column;
+  }
+
+  std::size_t index(Position pos) const { return cellIndex(m_size, pos); }
+  Position position(std::size_t id) const { return cellPosition(m_size, id); }
+
+  BitPlane &flags(std::size_t plane) { return m_flags[plane]; }
+  const BitPlane &flags(std::size_t plane) const { return m_flags[plane]; }
+  NibblePlane &counts(std::size_t plane) { return m_counts[plane]; }
+  const NibblePlane &counts(std::size_t plane) const {
+    return m_counts[plane];
+  }
+
+  bool flag(std::size_t plane, Position pos) const {
+    return m_flags[plane].test(index(pos));
+  }
+  void setFlag(std::size_t plane, Position pos, bool value = true) {
+    m_flags[plane].set(index(pos), value);
+  }
+  int count(std::size_t plane, Position pos) const {
+    return m_counts[plane].get(index(pos));
+  }
+  void setCount(std::size_t plane, Position pos, int value) {
+    m_counts[plane].set(index(pos), value);
+  }
+
+  /// memory used by the planes
+  std::size_t bytes() const {
+    std::size_t n = 0;
+    for (const auto &plane : m_flags) {
+      n += plane.bytes();
+    }
+    for (const auto &plane : m_counts) {
+      n += plane.bytes();
+    }
+    return n;
+  }
+};
@@ -0,0 +1,118 @@
+#pragma once
+#include "grid.h"
+#include "threadpool.h"
+
+#include <algorithm>
+#include <cstdint>
+#include <utility>
+#include <vector>
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+///
+/// byte plane stencils: a byte per cell, stored like Grid (column after
+/// column), so that a column is contiguous
+///
+namespace boxsum {
+
+// out[r] = column[r - 1] + column[r] + column[r + 1]
+inline void columnSums(const std::uint8_t *column, std::uint8_t *out,
+                       int rows) {
+  if (rows == 1) {
+    out[0] = column[0];
+    return;
+  }
+  out[0] = column[0] + column[1];
+  int r = 1;
+#if defined(__SSE2__)
+  for (; r + 16 < rows; r += 16) {
+    const __m128i above = _mm_loadu_si128(
+        reinterpret_cast<const __m128i *>(column + r - 1));
+    const __m128i center =
+        _mm_loadu_si128(reinterpret_cast<const __m128i *>(column + r));
+    const __m128i below =
+        _mm_loadu_si128(reinterpret_cast<const __m128i *>(column + r + 1));
+    _mm_storeu_si128(reinterpret_cast<__m128i *>(out + r),
+                     _mm_add_epi8(_mm_add_epi8(above, center), below));
+  }
+#endif
+  for (; r < rows - 1; r++) {
+    out[r] = column[r - 1] + column[r] + column[r + 1];
+  }
+  out[rows - 1] = column[rows - 2] + column[rows - 1];
+}
+
+// out[r] = left[r] + center[r] + right[r] - self[r]
+inline void combine(const std::uint8_t *left, const std::uint8_t *center,
+                    const std::uint8_t *right, const std::uint8_t *self,
+                    std::uint8_t *out, int rows) {
+  int r = 0;
+#if defined(__SSE2__)
+  for (; r + 16 <= rows; r += 16) {
+    auto load = [r](const std::uint8_t *p) {
+      return _mm_loadu_si128(reinterpret_cast<const __m128i *>(p + r));
+    };
+    const __m128i sum =
+        _mm_add_epi8(_mm_add_epi8(load(left), load(center)), load(right));
+    _mm_storeu_si128(reinterpret_cast<__m128i *>(out + r),
+                     _mm_sub_epi8(sum, load(self)));
+  }
+#endif
+  for (; r < rows; r++) {
+    out[r] = left[r] + center[r] + right[r] - self[r];
+  }
+}
+
+} // namespace boxsum
+
+///
+/// \brief neighborSums sets out[i] to the sum of in over the 8 neighbors of
+/// cell i, in one sweep: the 3x3 box sum is separated in a pass along the
+/// columns then a pass across them, both vectorized when SSE2 is available
+/// sums must fit in a byte, in values up to 31
+///
+/// with a pool, bands of columns are computed in parallel
+///
+inline void neighborSums(Size size, const std::uint8_t *in, std::uint8_t *out,
+                         ThreadPool *pool = nullptr) {
+  const int rows = size.row;
+  const int columns = size.column;
+  if (rows <= 0 || columns <= 0) {
+    return;
+  }
+
+  auto band = [=](std::size_t begin, std::size_t end) {
+    // column sums of the previous, current and next columns
+    std::vector<std::uint8_t> sums(3 * static_cast<std::size_t>(rows), 0);
+    std::uint8_t *left = sums.data();
+    std::uint8_t *center = left + rows;
+    std::uint8_t *right = center + rows;
+    auto column = [in, rows](std::size_t c) {
+      return in + c * static_cast<std::size_t>(rows);
+    };
+
+    if (begin > 0) {
+      boxsum::columnSums(column(begin - 1), left, rows);
+    }
+    boxsum::columnSums(column(begin), center, rows);
+    for (std::size_t c = begin; c < end; c++) {
+      if (c + 1 < static_cast<std::size_t>(columns)) {
+        boxsum::columnSums(column(c + 1), right, rows);
+      } else {
+        std::fill(right, right + rows, 0);
+      }
+      boxsum::combine(left, center, right, column(c),
+                      out + c * static_cast<std::size_t>(rows), rows);
+      std::swap(left, center);
+      std::swap(center, right);
+    }
+  };
+
+  if (pool) {
+    pool->parallelFor(static_cast<std::size_t>(columns), band);
+  } else {
+    band(0, static_cast<std::size_t>(columns));
+  }
+}
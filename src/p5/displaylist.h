@@ -0,0 +1,242 @@
+#pragma once
+
+#include "application.h"
+
+#include <cstdint>
+#include <initializer_list>
+#include <string>
+#include <utility>
+#include <vector>
+
+///
+/// \brief The DisplayList class is a recorded frame: Canvas drawing
+/// primitives and state changes packed in a buffer of 32 bit words, an
+/// opcode followed by its arguments, text is kept aside
+/// a list has no Qt dependency, it can be built on any thread and replayed
+/// later on a canvas that is drawing
+///
+class DisplayList {
+public:
+  enum class Op : std::int32_t {
+    Background, // rgb
+    Stroke,     // rgb
+    NoStroke,
+    Fill, // rgb
+    NoFill,
+    Line,  // x1 y1 x2 y2
+    Rect,  // x y w h
+    Rects, // count, then x y w h per rect
+    Text,  // string index, x y
+  };
+
+  void clear() {
+    m_words.clear();
+    m_strings.clear();
+    m_commands = 0;
+  }
+
+  bool empty() const { return m_commands == 0; }
+  /// number of recorded commands
+  std::size_t size() const { return m_commands; }
+  /// memory used by the commands
+  std::size_t bytes() const {
+    std::size_t n = m_words.size() * sizeof(std::int32_t);
+    for (const auto &str : m_strings) {
+      n += str.size();
+    }
+    return n;
+  }
+
+  void background(int r, int g, int b) {
+    push(Op::Background, {rgb(r, g, b)});
+  }
+  void stroke(int r, int g, int b) { push(Op::Stroke, {rgb(r, g, b)}); }
+  void noStroke() { push(Op::NoStroke, {}); }
+  void fill(int r, int g, int b) { push(Op::Fill, {rgb(r, g, b)}); }
+  void noFill() { push(Op::NoFill, {}); }
+  void line(int x1, int y1, int x2, int y2) {
+    push(Op::Line, {x1, y1, x2, y2});
+  }
+  void rect(int x, int y, int w, int h) { push(Op::Rect, {x, y, w, h}); }
+  void rects(const std::vector<Rect> &rects) {
+    push(Op::Rects, {static_cast<std::int32_t>(rects.size())});
+    for (const auto &r : rects) {
+      m_words.insert(m_words.end(), {r.x, r.y, r.w, r.h});
+    }
+  }
+  void text(std::string str, int x, int y) {
+    push(Op::Text, {static_cast<std::int32_t>(m_strings.size()), x, y});
+    m_strings.push_back(std::move(str));
+  }
+
+  ///
+  /// \brief replay calls the recorded primitives on canvas, in order
+  /// canvas must be drawing
+  ///
+  void replay(Canvas &canvas) const {
+    std::vector<Rect> rects;
+    const std::int32_t *w = m_words.data();
+    const std::int32_t *end = w + m_words.size();
+    while (w < end) {
+      switch (static_cast<Op>(*w++)) {
+      case Op::Background:
+        canvas.background(red(w[0]), green(w[0]), blue(w[0]));
+        w += 1;
+        break;
+      case Op::Stroke:
+        canvas.stroke(red(w[0]), green(w[0]), blue(w[0]));
+        w += 1;
+        break;
+      case Op::NoStroke:
+        canvas.noStroke();
+        break;
+      case Op::Fill:
+        canvas.fill(red(w[0]), green(w[0]), blue(w[0]));
+        w += 1;
+        break;
+      case Op::NoFill:
+        canvas.noFill();
+        break;
+      case Op::Line:
+        canvas.line(w[0], w[1], w[2], w[3]);
+        w += 4;
+        break;
+      case Op::Rect:
+        canvas.rect(w[0], w[1], w[2], w[3]);
+        w += 4;
+        break;
+      case Op::Rects: {
+        const std::int32_t count = *w++;
+        rects.resize(static_cast<std::size_t>(count));
+        for (auto &r : rects) {
+          r = Rect{w[0], w[1], w[2], w[3]};
+          w += 4;
+        }
+        canvas.rects(rects);
+        break;
+      }
+      case Op::Text:
+        canvas.text(m_strings[static_cast<std::size_t>(w[0])], w[1], w[2]);
+        w += 3;
+        break;
+      default:
+        throw std::runtime_error("DisplayList::replay; unknown opcode");
+      }
+    }
+  }
+
+  /// same commands, a frame equal to the previous one need not be drawn
+  bool operator==(const DisplayList &other) const {
+    return m_words == other.m_words && m_strings == other.m_strings;
+  }
+  bool operator!=(const DisplayList &other) const { return !(*this == other); }
+
+  /// FNV-1a over the commands, to key a cache of lists
+  std::uint64_t hash() const {
+    std::uint64_t h = 0xcbf29ce484222325ull;
+    auto mix = [&h](std::uint32_t value) {
+      for (int byte = 0; byte < 4; byte++) {
+        h = (h ^ ((value >> (8 * byte)) & 0xff)) * 0x100000001b3ull;
+      }
+    };
+    for (auto word : m_words) {
+      mix(static_cast<std::uint32_t>(word));
+    }
+    for (const auto &str : m_strings) {
+      for (unsigned char c : str) {
+        h = (h ^ c) * 0x100000001b3ull;
+      }
+      mix(static_cast<std::uint32_t>(str.size()));
+    }
+    return h;
+  }
+
+private:
+  std::vector<std::int32_t> m_words;
+  std::vector<std::string> m_strings;
+  std::size_t m_commands{0};
+
+  void push(Op op, std::initializer_list<std::int32_t> args) {
+    m_words.push_back(static_cast<std::int32_t>(op));
+    m_words.insert(m_words.end(), args);
+    m_commands++;
+  }
+
+  static std::int32_t rgb(int r, int g, int b) {
+    return (r & 0xff) << 16 | (g & 0xff) << 8 | (b & 0xff);
+  }
+  static int red(std::int32_t rgb) { return (rgb >> 16) & 0xff; }
+  static int green(std::int32_t rgb) { return (rgb >> 8) & 0xff; }
+  static int blue(std::int32_t rgb) { return rgb & 0xff; }
+};
+
+///
+/// \brief The RecordingCanvas class implements canvas into a DisplayList
+/// it is always drawing and needs no painter, a draw() can run on any
+/// thread, one thread per canvas; there is no user input
+///
+class RecordingCanvas : public Canvas {
+
+  DisplayList m_list;
+  int m_width;
+  int m_height;
+  int m_framerate{30};
+  bool m_loop{true};
+
+public:
+  RecordingCanvas(int width = 640, int height = 480)
+      : m_width(width), m_height(height) {}
+
+  const DisplayList &list() const { return m_list; }
+  /// hand over the recorded list, the canvas starts a new one
+  DisplayList take() {
+    DisplayList list = std::move(m_list);
+    m_list.clear();
+    return list;
+  }
+
+  bool looping() const { return m_loop; }
+  int framerate() const { return m_framerate; }
+
+  // Canvas interface
+  void setSize(int width, int height) override {
+    m_width = width;
+    m_height = height;
+  }
+  void setFramerate(int framerate) override { m_framerate = framerate; }
+
+  void background(int r, int g, int b) override {
+    m_list.background(r, g, b);
+  }
+
+  void stroke(int r, int g, int b) override { m_list.stroke(r, g, b); }
+  void noStroke() override { m_list.noStroke(); }
+  void fill(int r, int g, int b) override { m_list.fill(r, g, b); }
+  void noFill() override { m_list.noFill(); }
+
+  void line(int x1, int y1, int x2, int y2) override {
+    m_list.line(x1, y1, x2, y2);
+  }
+  void rect(int x, int y, int w, int h) override { m_list.rect(x, y, w, h); }
+  void rects(const std::vector<Rect> &rects) override { m_list.rects(rects); }
+
+  void text(std::string str, int x, int y) override {
+    m_list.text(std::move(str), x, y);
+  }
+
+  int width() const override { return m_width; }
+  int height() const override { return m_height; }
+
+  void noLoop() override { m_loop = false; }
+
+  int mouseX() const override { return 0; }
+  int mouseY() const override { return 0; }
+
+  bool isMouseLeft() const override { return false; }
+  bool isMouseRight() const override { return false; }
+
+  char key() const override { return '\0'; }
+
+protected:
+  bool isDrawing() const override { return true; }
+};
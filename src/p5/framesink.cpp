@@ -0,0 +1,200 @@
+#include "framesink.h"
+
+#include <algorithm>
+#include <stdexcept>
+
+namespace {
+bool endsWith(const std::string &str, const std::string &suffix) {
+  return str.size() >= suffix.size() &&
+         std::equal(suffix.rbegin(), suffix.rend(), str.rbegin());
+}
+
+// full range BT.601, as declared by C420jpeg
+std::uint8_t toY(int r, int g, int b) {
+  return static_cast<std::uint8_t>((77 * r + 150 * g + 29 * b + 128) >> 8);
+}
+std::uint8_t toU(int r, int g, int b) {
+  return static_cast<std::uint8_t>(
+      std::clamp((-43 * r - 85 * g + 128 * b + 128) / 256 + 128, 0, 255));
+}
+std::uint8_t toV(int r, int g, int b) {
+  return static_cast<std::uint8_t>(
+      std::clamp((128 * r - 107 * g - 21 * b + 128) / 256 + 128, 0, 255));
+}
+} // namespace
+
+FrameSink::FrameSink(const std::string &target, int width, int height,
+                     int framerate)
+    : FrameSink(target, formatFor(target), width, height, framerate) {}
+
+FrameSink::FrameSink(const std::string &target, Format format, int width,
+                     int height, int framerate)
+    : m_format(format), m_width(width), m_height(height) {
+
+  if (target == "-") {
+    m_file = stdout;
+  } else if (!target.empty() && target[0] == '|') {
+    m_file = ::popen(target.c_str() + 1, "w");
+    m_pipe = true;
+  } else {
+    m_file = std::fopen(target.c_str(), "wb");
+  }
+
+  if (!m_file) {
+    throw std::runtime_error("FrameSink: cannot open " + target);
+  }
+
+  if (m_format == Format::Y4M) {
+    std::fprintf(m_file, "YUV4MPEG2 W%d H%d F%d:1 Ip A1:1 C420jpeg\n", width,
+                 height, std::max(framerate, 1));
+  }
+}
+
+FrameSink::~FrameSink() {
+  if (m_file == stdout) {
+    std::fflush(m_file);
+  } else if (m_pipe) {
+    ::pclose(m_file);
+  } else {
+    std::fclose(m_file);
+  }
+}
+
+FrameSink::Format FrameSink::formatFor(const std::string &target) {
+  return endsWith(target, ".ppm") ? Format::PPM : Format::Y4M;
+}
+
+void FrameSink::write(const QImage &frame) {
+  if (frame.width() != m_width || frame.height() != m_height) {
+    throw std::runtime_error("FrameSink::write; frame size changed");
+  }
+
+  const QImage rgb = frame.format() == QImage::Format_RGB32
+                         ? frame
+                         : frame.convertToFormat(QImage::Format_RGB32);
+
+  if (m_format == Format::Y4M) {
+    writeY4M(rgb);
+  } else {
+    writePPM(rgb);
+  }
+  m_frames++;
+}
+
+void FrameSink::put(const void *data, std::size_t size) {
+  if (std::fwrite(data, 1, size, m_file) != size) {
+    throw std::runtime_error("FrameSink: write failed");
+  }
+}
+
+void FrameSink::writePPM(const QImage &frame) {
+  std::fprintf(m_file, "P6\n%d %d\n255\n", m_width, m_height);
+
+  m_buffer.resize(static_cast<std::size_t>(m_width) * 3);
+  for (int y = 0; y < m_height; y++) {
+    auto line = reinterpret_cast<const QRgb *>(frame.constScanLine(y));
+    auto out = m_buffer.data();
+    for (int x = 0; x < m_width; x++) {
+      *out++ = static_cast<std::uint8_t>(qRed(line[x]));
+      *out++ = static_cast<std::uint8_t>(qGreen(line[x]));
+      *out++ = static_cast<std::uint8_t>(qBlue(line[x]));
+    }
+    put(m_buffer.data(), m_buffer.size());
+  }
+}
+
+void FrameSink::writeY4M(const QImage &frame) {
+  const int cw = (m_width + 1) / 2;
+  const int ch = (m_height + 1) / 2;
+  const std::size_t luma = static_cast<std::size_t>(m_width) * m_height;
+  const std::size_t chroma = static_cast<std::size_t>(cw) * ch;
+
+  m_buffer.resize(luma + 2 * chroma);
+  auto Y = m_buffer.data();
+  auto U = Y + luma;
+  auto V = U + chroma;
+
+  for (int y = 0; y < m_height; y++) {
+    auto line = reinterpret_cast<const QRgb *>(frame.constScanLine(y));
+    for (int x = 0; x < m_width; x++) {
+      Y[y * m_width + x] = toY(qRed(line[x]), qGreen(line[x]), qBlue(line[x]));
+    }
+  }
+
+  // chroma is averaged over 2x2 blocks
+  for (int cy = 0; cy < ch; cy++) {
+    auto l0 = reinterpret_cast<const QRgb *>(frame.constScanLine(2 * cy));
+    auto l1 = reinterpret_cast<const QRgb *>(
+        frame.constScanLine(std::min(2 * cy + 1, m_height - 1)));
+    for (int cx = 0; cx < cw; cx++) {
+      const int x0 = 2 * cx;
+      const int x1 = std::min(x0 + 1, m_width - 1);
+      const int r =
+          (qRed(l0[x0]) + qRed(l0[x1]) + qRed(l1[x0]) + qRed(l1[x1]) + 2) / 4;
+      const int g = (qGreen(l0[x0]) + qGreen(l0[x1]) + qGreen(l1[x0]) +
+                     qGreen(l1[x1]) + 2) /
+                    4;
+      const int b = (qBlue(l0[x0]) + qBlue(l0[x1]) + qBlue(l1[x0]) +
+                     qBlue(l1[x1]) + 2) /
+                    4;
+      U[cy * cw + cx] = toU(r, g, b);
+      V[cy * cw + cx] = toV(r, g, b);
+    }
+  }
+
+  static const char header[] = "FRAME\n";
+  put(header, sizeof(header) - 1);
+  put(m_buffer.data(), m_buffer.size());
+}
+
+FrameRecorder::FrameRecorder(std::unique_ptr<FrameSink> sink,
+                             std::size_t max_pending)
+    : m_sink(std::move(sink)), m_max_pending(std::max<std::size_t>(
+                                   max_pending, 1)),
+      m_worker([this]() { run(); }) {}
+
+FrameRecorder::~FrameRecorder() {
+  {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_stop = true;
+  }
+  m_cond.notify_all();
+  m_worker.join();
+}
+
+void FrameRecorder::push(QImage frame) {
+  std::unique_lock<std::mutex> lock(m_mutex);
+  m_cond.wait(lock, [this]() {
+    return m_error || m_pending.size() < m_max_pending;
+  });
+  if (m_error) {
+    std::rethrow_exception(m_error);
+  }
+  m_pending.push_back(std::move(frame));
+  lock.unlock();
+  m_cond.notify_all();
+}
+
+void FrameRecorder::run() {
+  for (;;) {
+    std::unique_lock<std::mutex> lock(m_mutex);
+    m_cond.wait(lock, [this]() { return m_stop || !m_pending.empty(); });
+    if (m_pending.empty()) {
+      return; // stopped and drained
+    }
+    QImage frame = std::move(m_pending.front());
+    m_pending.pop_front();
+    lock.unlock();
+    m_cond.notify_all();
+
+    try {
+      m_sink->write(frame);
+    } catch (...) {
+      lock.lock();
+      m_error = std::current_exception();
+      m_pending.clear();
+      lock.unlock();
+      m_cond.notify_all();
+    }
+  }
+}
@@ -0,0 +1,84 @@
+#pragma once
+
+#include <QImage>
+
+#include <condition_variable>
+#include <cstdint>
+#include <cstdio>
+#include <deque>
+#include <exception>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+///
+/// \brief The FrameSink class writes raw video frames to a file or a pipe
+/// Y4M (yuv 4:2:0) by default, a stream of binary PPM when target ends with
+/// ".ppm"
+/// target can be a path, "-" for stdout or "|command" to pipe to a process
+/// (e.g. "|ffmpeg -i - run.mp4")
+///
+class FrameSink {
+public:
+  enum class Format { Y4M, PPM };
+
+  FrameSink(const std::string &target, int width, int height, int framerate);
+  FrameSink(const std::string &target, Format format, int width, int height,
+            int framerate);
+  ~FrameSink();
+
+  FrameSink(const FrameSink &) = delete;
+  FrameSink &operator=(const FrameSink &) = delete;
+
+  void write(const QImage &frame);
+
+  static Format formatFor(const std::string &target);
+
+  int frameCount() const { return m_frames; }
+
+private:
+  void writeY4M(const QImage &frame);
+  void writePPM(const QImage &frame);
+  void put(const void *data, std::size_t size);
+
+  Format m_format;
+  int m_width;
+  int m_height;
+  int m_frames{0};
+  std::FILE *m_file{};
+  bool m_pipe{false};
+  std::vector<std::uint8_t> m_buffer;
+};
+
+///
+/// \brief The FrameRecorder class encodes and writes frames on a worker thread
+/// push() only blocks when max_pending frames are already waiting
+///
+class FrameRecorder {
+public:
+  explicit FrameRecorder(std::unique_ptr<FrameSink> sink,
+                         std::size_t max_pending = 8);
+  /// write pending frames then stop the worker
+  ~FrameRecorder();
+
+  FrameRecorder(const FrameRecorder &) = delete;
+  FrameRecorder &operator=(const FrameRecorder &) = delete;
+
+  /// frame must not be shared with a painter still in use
+  /// rethrows the first error raised by the sink
+  void push(QImage frame);
+
+private:
+  void run();
+
+  std::unique_ptr<FrameSink> m_sink;
+  std::size_t m_max_pending;
+  std::deque<QImage> m_pending;
+  std::mutex m_mutex;
+  std::condition_variable m_cond;
+  bool m_stop{false};
+  std::exception_ptr m_error;
+  std::thread m_worker;
+};
@@ -1,10 +1,17 @@
 #pragma once
+#include <algorithm>
 #include <array>
+#include <cstdint>
+#include <deque>
 #include <functional>
 #include <iostream>
+#include <stdexcept>
 #include <tuple>
+#include <type_traits>
 #include <vector>
 
+#include "threadpool.h"
+
 struct Size {
   int row;
   int column;
@@ -32,63 +39,517 @@ struct Position {
            std::make_tuple(other_p.column, other_p.row);
   }
 
-  std::vector<Position> Neighbors() const {
+  /// the 8 surrounding positions, some may be outside the grid
+  std::array<Position, 8> Neighbors() const;
+};
+
+///
+/// \brief The Stencil struct is a compile time table of neighbor offsets:
+/// the cells at most Radius steps away, diagonal steps allowed or not
+/// Stencil<1, false> is 4-connectivity, Stencil<1, true> 8-connectivity
+///
+template <int Radius, bool Diagonal> struct Stencil {
+  static_assert(Radius > 0, "a stencil has at least one neighbor");
+
+  static constexpr int radius = Radius;
+
+  static constexpr bool contains(int column, int row) {
+    const int c = column < 0 ? -column : column;
+    const int r = row < 0 ? -row : row;
+    if (c == 0 && r == 0) {
+      return false;
+    }
+    return Diagonal ? c <= Radius && r <= Radius : c + r <= Radius;
+  }
 
-    std::vector<Position> ret(8);
+  static constexpr std::size_t count() {
+    std::size_t n = 0;
+    for (int column = -Radius; column <= Radius; column++) {
+      for (int row = -Radius; row <= Radius; row++) {
+        n += contains(column, row);
+      }
+    }
+    return n;
+  }
 
-    for (int col = -1; col <= 1; col++) {
-      for (int r = -1; r <= 1; r++) {
-        Position pos{column + col, row + r};
-        if (pos != *this) {
-          ret.push_back(pos);
+  // in grid storage order, column then row
+  static constexpr std::array<Position, count()> make() {
+    std::array<Position, count()> table{};
+    std::size_t n = 0;
+    for (int column = -Radius; column <= Radius; column++) {
+      for (int row = -Radius; row <= Radius; row++) {
+        if (contains(column, row)) {
+          table[n++] = Position{column, row};
         }
       }
     }
+    return table;
+  }
+
+  static constexpr std::array<Position, count()> offsets = make();
+};
+
+using FourNeighbors = Stencil<1, false>;
+using EightNeighbors = Stencil<1, true>;
+
+inline std::array<Position, 8> Position::Neighbors() const {
+  std::array<Position, 8> ret{};
+  for (std::size_t i = 0; i < ret.size(); i++) {
+    ret[i] = {column + EightNeighbors::offsets[i].column,
+              row + EightNeighbors::offsets[i].row};
+  }
+  return ret;
+}
+
+///
+/// cells of a grid are stored column after column, these functions work on
+/// cell indices so that any storage of that layout can share them
+///
+inline std::size_t cellIndex(Size size, Position pos) {
+  return static_cast<std::size_t>(pos.column) * size.row + pos.row;
+}
+
+inline Position cellPosition(Size size, std::size_t id) {
+  return {static_cast<int>(id / size.row), static_cast<int>(id % size.row)};
+}
+
+/// calls cb with the index of each neighbor of pos inside the grid, cells far
+/// enough from the border skip the bounds checks
+template <typename S, typename F>
+void forEachNeighborIndex(Size size, Position pos, F &&cb) {
+  if (pos.column >= S::radius && pos.row >= S::radius &&
+      pos.column + S::radius < size.column && pos.row + S::radius < size.row) {
+    const std::size_t center = cellIndex(size, pos);
+    for (const Position &offset : S::offsets) {
+      cb(center + offset.column * size.row + offset.row);
+    }
+    return;
+  }
+
+  for (const Position &offset : S::offsets) {
+    const Position neighbor{pos.column + offset.column, pos.row + offset.row};
+    if (neighbor.valid(size)) {
+      cb(cellIndex(size, neighbor));
+    }
+  }
+}
+
+///
+/// \brief floodFill visits the region connected to start, without
+/// recursion: visit(index) is called once per reached cell and returns
+/// whether the fill goes on through the neighbors of that cell, cells for
+/// which enter(index) is false are not reached
+/// returns the number of visited cells
+///
+/// memory is one bit per cell plus a queue of the fill front
+///
+template <typename S = EightNeighbors, typename Enter, typename Visit>
+std::size_t floodFill(Size size, Position start, Enter &&enter,
+                      Visit &&visit) {
+  if (!start.valid(size) || !enter(cellIndex(size, start))) {
+    return 0;
+  }
+
+  const std::size_t cells = static_cast<std::size_t>(size.row) * size.column;
+  std::vector<std::uint64_t> visited((cells + 63) / 64, 0);
+  auto mark = [&visited](std::size_t id) {
+    const std::uint64_t bit = std::uint64_t{1} << (id % 64);
+    const bool seen = visited[id / 64] & bit;
+    visited[id / 64] |= bit;
+    return !seen;
+  };
+
+  std::deque<std::size_t> front;
+  front.push_back(cellIndex(size, start));
+  mark(front.back());
+
+  std::size_t count = 0;
+  while (!front.empty()) {
+    const std::size_t id = front.front();
+    front.pop_front();
+    count++;
+    if (!visit(id)) {
+      continue;
+    }
+    forEachNeighborIndex<S>(size, cellPosition(size, id),
+                            [&](std::size_t neighbor) {
+                              if (mark(neighbor) && enter(neighbor)) {
+                                front.push_back(neighbor);
+                              }
+                            });
+  }
+  return count;
+}
+
+///
+/// \brief The Tile struct is a block of cells stored contiguously, column
+/// after column, by a grid layout
+///
+struct Tile {
+  Position origin;
+  Size size;
+  std::size_t offset; // index of its first cell in the storage
+};
+
+///
+/// \brief The ColumnMajor struct is the default Grid layout: column after
+/// column, its tiles are bands of TileColumns full columns
+///
+struct ColumnMajor {
+  static constexpr int TileColumns = 64;
+
+  static std::size_t index(Size size, Position pos) {
+    return cellIndex(size, pos);
+  }
+  static Position position(Size size, std::size_t id) {
+    return cellPosition(size, id);
+  }
+
+  /// size of the tiles away from the right border
+  static Size tileSize(Size size) { return {size.row, TileColumns}; }
+  static std::size_t tileCount(Size size) {
+    return (size.column + TileColumns - 1) / TileColumns;
+  }
+  static Tile tile(Size size, std::size_t k) {
+    const int column = static_cast<int>(k) * TileColumns;
+    return {{column, 0},
+            {size.row, std::min(TileColumns, size.column - column)},
+            cellIndex(size, {column, 0})};
+  }
+};
+
+///
+/// \brief The Tiled struct is a Grid layout of Side x Side tiles: tiles are
+/// stored column of tiles after column of tiles, cells column after column
+/// inside a tile, tiles on the right and bottom borders are smaller
+/// neighbors are mostly in the same tile, which stays in cache
+///
+template <int Side> struct Tiled {
+  static_assert(Side > 0, "tiles have at least one cell");
+
+  static std::size_t index(Size size, Position pos) {
+    const int tile_column = pos.column / Side;
+    const int tile_row = pos.row / Side;
+    const int width = std::min(Side, size.column - tile_column * Side);
+    const int height = std::min(Side, size.row - tile_row * Side);
+    return static_cast<std::size_t>(tile_column) * Side * size.row +
+           static_cast<std::size_t>(tile_row) * Side * width +
+           static_cast<std::size_t>(pos.column % Side) * height +
+           pos.row % Side;
+  }
+
+  static Position position(Size size, std::size_t id) {
+    const std::size_t band = static_cast<std::size_t>(Side) * size.row;
+    const int tile_column = static_cast<int>(id / band);
+    id %= band;
+    const int width = std::min(Side, size.column - tile_column * Side);
+    const int tile_row = static_cast<int>(id / (Side * width));
+    id %= static_cast<std::size_t>(Side) * width;
+    const int height = std::min(Side, size.row - tile_row * Side);
+    return {tile_column * Side + static_cast<int>(id / height),
+            tile_row * Side + static_cast<int>(id % height)};
+  }
+
+  /// distance between two columns of the tile of pos, 0 when the cells
+  /// within radius of pos are not all in that tile
+  static int innerStride(Size size, Position pos, int radius) {
+    const int column = pos.column % Side;
+    const int row = pos.row % Side;
+    const int width = std::min(Side, size.column - pos.column / Side * Side);
+    const int height = std::min(Side, size.row - pos.row / Side * Side);
+    if (column < radius || row < radius || column + radius >= width ||
+        row + radius >= height) {
+      return 0;
+    }
+    return height;
+  }
+
+  /// size of the tiles away from the right and bottom borders
+  static Size tileSize(Size) { return {Side, Side}; }
 
-    return ret;
+  static std::size_t tileCount(Size size) {
+    return static_cast<std::size_t>((size.column + Side - 1) / Side) *
+           ((size.row + Side - 1) / Side);
+  }
+  static Tile tile(Size size, std::size_t k) {
+    const std::size_t rows = (size.row + Side - 1) / Side;
+    const Position origin{static_cast<int>(k / rows) * Side,
+                          static_cast<int>(k % rows) * Side};
+    return {origin,
+            {std::min(Side, size.row - origin.row),
+             std::min(Side, size.column - origin.column)},
+            index(size, origin)};
   }
 };
 
-template <typename T> class Grid {
+///
+/// \brief The Grid class stores a T per cell, T is built from its Position
+/// and has a position member
+/// Layout orders the cells in memory: ColumnMajor or Tiled<Side>
+///
+template <typename T, typename Layout = ColumnMajor> class Grid {
   Size m_size;
   std::vector<T> m_cells;
+  std::vector<std::size_t> m_dirty; // storage indices, in marking order
+  std::vector<bool> m_dirty_flags;
 
   std::vector<T> make_grid() const {
     std::vector<T> grid;
-    for (int i = 0; i < m_size.column; i++) {
-      for (int j = 0; j < m_size.row; j++) {
-        Position pos;
-        pos.column = i;
-        pos.row = j;
-        grid.emplace_back(pos);
-      }
+    grid.reserve(static_cast<std::size_t>(m_size.row) * m_size.column);
+    for (std::size_t id = 0; id < grid.capacity(); id++) {
+      grid.emplace_back(Layout::position(m_size, id));
     }
     return grid;
   }
 
+  static constexpr bool IsColumnMajor = std::is_same_v<Layout, ColumnMajor>;
+
 public:
-  Grid(Size size) : m_size(size), m_cells(make_grid()) {}
+  Grid(Size size)
+      : m_size(size), m_cells(make_grid()), m_dirty_flags(m_cells.size()) {}
 
-  void forEach(std::function<void(T &)> cb) {
+  Size size() const { return m_size; }
+
+  /// cells in storage order
+  template <typename F> void forEach(F &&cb) {
     for (auto &cell : m_cells) {
       cb(cell);
     }
   }
 
-  void forEachNeighbor(const T &cell_p, std::function<void(T &)> cb) {
+  /// tiles are dispatched to the pool, cb must be safe to call concurrently
+  /// on different cells
+  template <typename F> void forEach(F &&cb, ThreadPool &pool) {
+    auto tile = [&cb](const Tile &, T *cells, std::size_t count) {
+      for (std::size_t i = 0; i < count; i++) {
+        cb(cells[i]);
+      }
+    };
+    forEachTile(tile, &pool);
+  }
+
+  ///
+  /// \brief forEachTile calls cb(tile, cells, count) for each tile of the
+  /// layout, cells are the count cells of the tile, column after column
+  /// with a pool, tiles are processed in parallel
+  ///
+  template <typename F> void forEachTile(F &&cb, ThreadPool *pool = nullptr) {
+    const std::size_t tiles = Layout::tileCount(m_size);
+    auto run = [this, &cb](std::size_t begin, std::size_t end) {
+      for (std::size_t k = begin; k < end; k++) {
+        const Tile tile = Layout::tile(m_size, k);
+        cb(tile, &m_cells[tile.offset],
+           static_cast<std::size_t>(tile.size.row) * tile.size.column);
+      }
+    };
+    if (pool) {
+      pool->parallelFor(tiles, run, std::min(tiles, pool->size() * 4));
+    } else {
+      run(0, tiles);
+    }
+  }
+
+  ///
+  /// \brief forEachWithNeighbors calls cb(cell, neighbors) for each cell,
+  /// neighbors(f) calls f once for each neighbor of cell inside the grid
+  /// cells are walked tile by tile: inside a tile, neighbors are at fixed
+  /// offsets worked out once per tile, cells on the tile border reach the
+  /// tiles around through their first cell, also found once per tile
+  /// with a pool, tiles are processed in parallel
+  ///
+  template <typename S = EightNeighbors, typename F>
+  void forEachWithNeighbors(F &&cb, ThreadPool *pool = nullptr) {
+    const Size nominal = Layout::tileSize(m_size);
+    if (S::radius > nominal.row || S::radius > nominal.column) {
+      // neighbors may be further than the tiles around
+      forEachTile(
+          [this, &cb](const Tile &, T *cells, std::size_t count) {
+            for (std::size_t i = 0; i < count; i++) {
+              T &cell = cells[i];
+              cb(cell,
+                 [this, &cell](auto &&f) { forEachNeighbor<S>(cell, f); });
+            }
+          },
+          pool);
+      return;
+    }
 
-    auto pos = cell_p.position;
+    auto walk = [this, &cb, nominal](const Tile &tile, T *cells, std::size_t) {
+      const int height = tile.size.row;
+      const int width = tile.size.column;
+      std::array<std::ptrdiff_t, S::offsets.size()> offsets;
+      for (std::size_t k = 0; k < offsets.size(); k++) {
+        offsets[k] =
+            std::ptrdiff_t{S::offsets[k].column} * height + S::offsets[k].row;
+      }
+      auto inner = [&offsets](T &cell) {
+        return [&cell, &offsets](auto &&f) {
+          for (auto offset : offsets) {
+            f((&cell)[offset]);
+          }
+        };
+      };
+      // border cells reach the 3 x 3 tiles around by their first cell and
+      // size, worked out once per tile; nullptr outside the grid, the right
+      // and bottom tiles may be narrower than the stencil
+      T *around[3][3];
+      int widths[3];
+      int heights[3];
+      for (int tx = 0; tx < 3; tx++) {
+        const int column = tile.origin.column + (tx - 1) * nominal.column;
+        widths[tx] = std::min(nominal.column, m_size.column - column);
+      }
+      for (int ty = 0; ty < 3; ty++) {
+        const int row = tile.origin.row + (ty - 1) * nominal.row;
+        heights[ty] = std::min(nominal.row, m_size.row - row);
+        for (int tx = 0; tx < 3; tx++) {
+          const Position origin{tile.origin.column + (tx - 1) * nominal.column,
+                                row};
+          around[tx][ty] =
+              origin.valid(m_size) ? &m_cells[index(origin)] : nullptr;
+        }
+      }
+      // for the cells of column c on the tile border, the columns c - radius
+      // to c + radius in the tiles above, alongside and below
+      constexpr int span = 2 * S::radius + 1;
+      T *columns[span][3];
+      auto border = [&columns, &heights, nominal, height](int r) {
+        return [&columns, &heights, nominal, height, r](auto &&f) {
+          for (const Position &offset : S::offsets) {
+            int row = r + offset.row;
+            const int ty = row < 0 ? 0 : row < height ? 1 : 2;
+            T *column = columns[offset.column + S::radius][ty];
+            row = ty == 0 ? row + nominal.row : ty == 2 ? row - height : row;
+            if (column && row < heights[ty]) {
+              f(column[row]);
+            }
+          }
+        };
+      };
 
-    for (auto neighbor : pos.Neighbors()) {
-      if (neighbor.valid(m_size)) {
-        cb(at(neighbor));
+      for (int c = 0; c < width; c++) {
+        for (int dc = 0; dc < span; dc++) {
+          int column = c + dc - S::radius;
+          const int tx = column < 0 ? 0 : column < width ? 1 : 2;
+          column = tx == 0 ? column + nominal.column
+                           : tx == 2 ? column - width : column;
+          for (int ty = 0; ty < 3; ty++) {
+            T *base = column < widths[tx] ? around[tx][ty] : nullptr;
+            columns[dc][ty] =
+                base ? base + static_cast<std::size_t>(column) * heights[ty]
+                     : nullptr;
+          }
+        }
+        T *column = cells + static_cast<std::size_t>(c) * height;
+        if (c < S::radius || c + S::radius >= width) {
+          for (int r = 0; r < height; r++) {
+            cb(column[r], border(r));
+          }
+          continue;
+        }
+        const int last = std::max(S::radius, height - S::radius);
+        for (int r = 0; r < std::min(S::radius, height); r++) {
+          cb(column[r], border(r));
+        }
+        for (int r = S::radius; r < last; r++) {
+          cb(column[r], inner(column[r]));
+        }
+        for (int r = last; r < height; r++) {
+          cb(column[r], border(r));
+        }
+      }
+    };
+    forEachTile(walk, pool);
+  }
+
+  ///
+  /// \brief forEachNeighbor calls cb once for each neighbor of cell inside
+  /// the grid, 8-connectivity unless another Stencil is given
+  ///
+  template <typename S = EightNeighbors, typename F>
+  void forEachNeighbor(const T &cell_p, F &&cb) {
+    if constexpr (IsColumnMajor) {
+      forEachNeighborIndex<S>(
+          m_size, cell_p.position,
+          [this, &cb](std::size_t id) { cb(m_cells[id]); });
+    } else {
+      const Position pos = cell_p.position;
+      if (const int stride = Layout::innerStride(m_size, pos, S::radius)) {
+        T *center = &m_cells[index(pos)];
+        for (const Position &offset : S::offsets) {
+          cb(center[offset.column * stride + offset.row]);
+        }
+        return;
+      }
+      for (const Position &offset : S::offsets) {
+        const Position neighbor{pos.column + offset.column,
+                                pos.row + offset.row};
+        if (neighbor.valid(m_size)) {
+          cb(m_cells[index(neighbor)]);
+        }
       }
     }
   }
 
+  /// ::floodFill with enter and visit called on cells
+  template <typename S = EightNeighbors, typename Enter, typename Visit>
+  std::size_t floodFill(Position start, Enter &&enter, Visit &&visit) {
+    // ::floodFill works on column major indices
+    auto cell = [this](std::size_t id) -> T & {
+      if constexpr (IsColumnMajor) {
+        return m_cells[id];
+      } else {
+        return m_cells[index(cellPosition(m_size, id))];
+      }
+    };
+    return ::floodFill<S>(
+        m_size, start, [&](std::size_t id) { return enter(cell(id)); },
+        [&](std::size_t id) { return visit(cell(id)); });
+  }
+
   T &at(Position pos_p) {
-    const int id = pos_p.column * (m_size.row) + (pos_p.row);
-    return m_cells.at(id);
+    if (!pos_p.valid(m_size)) {
+      throw std::out_of_range("Grid::at; position outside the grid");
+    }
+    return m_cells[index(pos_p)];
+  }
+
+  ///
+  /// dirty tracking: cells changed since the last clearDirty(), so that a
+  /// frame repaints those cells only
+  ///
+  void setDirty(const T &cell) {
+    const auto id = static_cast<std::size_t>(&cell - m_cells.data());
+    if (!m_dirty_flags[id]) {
+      m_dirty_flags[id] = true;
+      m_dirty.push_back(id);
+    }
+  }
+  void setAllDirty() {
+    for (const auto &cell : m_cells) {
+      setDirty(cell);
+    }
+  }
+  bool dirty() const { return !m_dirty.empty(); }
+  std::size_t dirtyCount() const { return m_dirty.size(); }
+
+  /// dirty cells in marking order
+  template <typename F> void forEachDirty(F &&cb) {
+    for (auto id : m_dirty) {
+      cb(m_cells[id]);
+    }
+  }
+
+  void clearDirty() {
+    for (auto id : m_dirty) {
+      m_dirty_flags[id] = false;
+    }
+    m_dirty.clear();
+  }
+
+private:
+  std::size_t index(Position pos_p) const {
+    return Layout::index(m_size, pos_p);
   }
 };
 
@@ -0,0 +1,208 @@
+#include "offscreencanvas.h"
+#include "framesink.h"
+
+#include <algorithm>
+#include <atomic>
+#include <cerrno>
+#include <csignal>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <iterator>
+#include <limits>
+#include <string>
+
+OffscreenCanvas::OffscreenCanvas(int width, int height)
+    : m_image(width, height, QImage::Format_RGB32) {
+  m_image.fill(QColor{255, 255, 255});
+}
+
+const QBrush &OffscreenCanvas::brush(const QColor &color) {
+  auto it = brushes.find(color.rgb());
+  if (it == brushes.end()) {
+    it = brushes.insert(color.rgb(), QBrush{color});
+  }
+  return *it;
+}
+
+void OffscreenCanvas::beginFrame(bool render) {
+  m_render = render;
+  m_drawing = true;
+  if (m_render) {
+    m_painter.begin(&m_image);
+  }
+}
+
+void OffscreenCanvas::endFrame() {
+  if (m_render) {
+    m_painter.end();
+  }
+  m_drawing = false;
+}
+
+void OffscreenCanvas::setSize(int width, int height) {
+  if (m_drawing) {
+    throw std::runtime_error("OffscreenCanvas::setSize; can not resize while "
+                             "drawing");
+  }
+  m_image = QImage(width, height, QImage::Format_RGB32);
+  m_image.fill(QColor{255, 255, 255});
+}
+
+void OffscreenCanvas::background(int r, int g, int b) {
+  if (rendering()) {
+    m_painter.fillRect(0, 0, width(), height(), QColor(r, g, b));
+  }
+}
+
+void OffscreenCanvas::stroke(int r, int g, int b) {
+  if (rendering()) {
+    m_painter.setPen(QColor{r, g, b});
+  }
+}
+
+void OffscreenCanvas::noStroke() {
+  if (rendering()) {
+    m_painter.setPen(QPen{Qt::NoPen});
+  }
+}
+
+void OffscreenCanvas::fill(int r, int g, int b) {
+  if (rendering()) {
+    m_painter.setBrush(brush(QColor{r, g, b}));
+  }
+}
+
+void OffscreenCanvas::noFill() {
+  if (rendering()) {
+    m_painter.setBrush(QBrush{});
+  }
+}
+
+void OffscreenCanvas::line(int x1, int y1, int x2, int y2) {
+  if (rendering()) {
+    m_painter.drawLine(x1, y1, x2, y2);
+  }
+}
+
+void OffscreenCanvas::rect(int x, int y, int w, int h) {
+  if (rendering()) {
+    m_painter.drawRect(x, y, w, h);
+  }
+}
+
+void OffscreenCanvas::rects(const std::vector<Rect> &rects) {
+  if (rendering()) {
+    batch.resize(0);
+    batch.reserve(static_cast<int>(rects.size()));
+    for (const auto &r : rects) {
+      batch.append(QRect{r.x, r.y, r.w, r.h});
+    }
+    m_painter.drawRects(batch);
+  }
+}
+
+void OffscreenCanvas::text(std::string str, int x, int y) {
+  if (rendering()) {
+    m_painter.drawText(x, y, QString::fromStdString(str));
+  }
+}
+
+namespace {
+/// value as a whole decimal number of at least min, or throws
+long number(const char *option, const char *value, long min,
+            const char *expects) {
+  char *end = nullptr;
+  errno = 0;
+  const long n = std::strtol(value, &end, 10);
+  if (end == value || *end != '\0' || errno == ERANGE || n < min) {
+    throw std::runtime_error(std::string(option) + " expects " + expects);
+  }
+  return n;
+}
+} // namespace
+
+std::optional<OffscreenOptions> OffscreenOptions::parse(int argc,
+                                                        char *argv[]) {
+  OffscreenOptions options;
+  bool record = false;
+
+  // options and what their value is
+  const char *const expects[][2] = {{"--record", "an output"},
+                                    {"--every", "a frame interval"},
+                                    {"--ticks", "a tick count"},
+                                    {"--size", "WIDTHxHEIGHT"}};
+
+  for (int i = 1; i < argc; i++) {
+    const char *arg = argv[i];
+    const auto known = std::find_if(
+        std::begin(expects), std::end(expects),
+        [arg](const auto &e) { return std::strcmp(arg, e[0]) == 0; });
+    if (known == std::end(expects)) {
+      continue;
+    }
+    if (i + 1 >= argc) {
+      throw std::runtime_error(std::string(arg) + " expects " + (*known)[1]);
+    }
+    const char *value = argv[++i];
+
+    if (std::strcmp(arg, "--record") == 0) {
+      options.output = value;
+      record = true;
+    } else if (std::strcmp(arg, "--every") == 0) {
+      options.every =
+          static_cast<int>(std::min<long>(number(arg, value, 1, (*known)[1]),
+                                          std::numeric_limits<int>::max()));
+    } else if (std::strcmp(arg, "--ticks") == 0) {
+      options.ticks = number(arg, value, 0, (*known)[1]);
+    } else if (std::strcmp(arg, "--size") == 0) {
+      if (std::sscanf(value, "%dx%d", &options.width, &options.height) != 2 ||
+          options.width <= 0 || options.height <= 0) {
+        throw std::runtime_error("--size expects WIDTHxHEIGHT");
+      }
+    }
+  }
+
+  if (!record) {
+    return std::nullopt;
+  }
+  return options;
+}
+
+namespace {
+std::atomic<bool> interrupted{false};
+}
+
+int runOffscreen(IApplication &app, const OffscreenOptions &options) {
+
+  OffscreenCanvas canvas(options.width, options.height);
+  app.setup(canvas);
+
+  FrameRecorder recorder(std::make_unique<FrameSink>(
+      options.output, canvas.width(), canvas.height(), canvas.framerate()));
+
+  // stop cleanly on ctrl-c so the last frames are flushed
+  std::signal(SIGINT, [](int) { interrupted = true; });
+
+  long tick = 0;
+  for (; canvas.looping() && !interrupted; tick++) {
+    if (options.ticks > 0 && tick >= options.ticks) {
+      break;
+    }
+    const bool render = tick % options.every == 0;
+
+    canvas.beginFrame(render);
+    app.draw(canvas);
+    canvas.endFrame();
+
+    if (render) {
+      // deep copy, the canvas keeps painting into its own image
+      recorder.push(canvas.image().copy());
+    }
+  }
+
+  std::cerr << "offscreen: " << tick << " ticks recorded to "
+            << options.output << '\n';
+  return 0;
+}
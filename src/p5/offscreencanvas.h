@@ -0,0 +1,105 @@
+#pragma once
+
+#include "application.h"
+#include <QHash>
+#include <QImage>
+#include <QPainter>
+#include <QVector>
+
+#include <optional>
+#include <string>
+
+///
+/// \brief The OffscreenCanvas class implements canvas into a QImage
+/// no window is needed, the application is driven as fast as possible
+/// by runOffscreen()
+///
+class OffscreenCanvas : public Canvas {
+
+  QImage m_image;
+  QPainter m_painter;
+  int m_framerate{30};
+  bool m_drawing{false};
+  bool m_render{true};
+  bool m_loop{true};
+  QHash<QRgb, QBrush> brushes;
+  QVector<QRect> batch;
+
+  const QBrush &brush(const QColor &color);
+
+  // drawing primitives are discarded on frames that are not rendered
+  bool rendering() {
+    ThrowIfNotDrawing();
+    return m_render;
+  }
+
+public:
+  OffscreenCanvas(int width = 640, int height = 480);
+
+  /// start a frame, when render is false drawing primitives are ignored
+  void beginFrame(bool render);
+  void endFrame();
+
+  const QImage &image() const { return m_image; }
+  bool looping() const { return m_loop; }
+  int framerate() const { return m_framerate; }
+
+  // Canvas interface
+  void setSize(int width, int height) override;
+  void setFramerate(int framerate) override { m_framerate = framerate; }
+
+  void background(int r, int g, int b) override;
+
+  void stroke(int r, int g, int b) override;
+  void noStroke() override;
+  void fill(int r, int g, int b) override;
+  void noFill() override;
+
+  void line(int x1, int y1, int x2, int y2) override;
+  void rect(int x, int y, int w, int h) override;
+  void rects(const std::vector<Rect> &rects) override;
+
+  void text(std::string str, int x, int y) override;
+
+  int width() const override { return m_image.width(); }
+  int height() const override { return m_image.height(); }
+
+  void noLoop() override { m_loop = false; }
+
+  // there is no user input offscreen
+  int mouseX() const override { return 0; }
+  int mouseY() const override { return 0; }
+
+  bool isMouseLeft() const override { return false; }
+  bool isMouseRight() const override { return false; }
+
+  char key() const override { return '\0'; }
+
+protected:
+  bool isDrawing() const override { return m_drawing; }
+};
+
+///
+/// \brief The OffscreenOptions struct holds the command line options of an
+/// offscreen run
+///
+struct OffscreenOptions {
+  std::string output;   // file path, "-" for stdout or "|command" for a pipe
+  int width{640};
+  int height{480};
+  int every{1};         // render one tick out of every
+  long ticks{0};        // 0 means until noLoop() or SIGINT
+
+  static constexpr const char *Usage =
+      "--record <output> [--every N] [--ticks N] [--size WxH]";
+
+  /// returns options when --record is given, throws std::runtime_error for
+  /// an option without a valid value
+  static std::optional<OffscreenOptions> parse(int argc, char *argv[]);
+};
+
+///
+/// \brief runOffscreen drives the application without window
+/// and streams rendered frames to options.output
+///
+int runOffscreen(IApplication &app, const OffscreenOptions &options);
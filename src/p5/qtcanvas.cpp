@@ -11,5 +11,5 @@ QtCanvas::QtCanvas(IApplication *app) : m_app(app) {
   app->setup(*this);
 
   // connect(&timer, SIGNAL(timeout()), this, SLOT(update()));
-  connect(&timer, &QTimer::timeout, this, [this]() { this->update(); });
+  connect(&timer, &QTimer::timeout, this, [this]() { refresh(); });
 }
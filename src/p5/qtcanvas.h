@@ -1,16 +1,33 @@
 #pragma once
 
 #include "application.h"
+#include "displaylist.h"
+#include "offscreencanvas.h"
+#include "textcache.h"
 #include <QApplication>
+#include <QHash>
 #include <QKeyEvent>
 #include <QMouseEvent>
 #include <QPainter>
+#include <QPixmap>
+#include <QRegion>
 #include <QTimer>
+#include <QVector>
 #include <QWidget>
+
+#include <iostream>
+#include <memory>
+#include <mutex>
+#include <utility>
 ///
 /// \brief The QtCanvas class implements canvas with Qt
 /// QPainter for Canvas drawing primitives
 /// QTimer to refresh canvas
+/// with partialRepaint, frames are drawn into a retained QPixmap, clipped to
+/// the areas given to redraw(), and a timer tick without redraw() paints
+/// nothing
+/// a DisplayList posted from any thread replaces the application draw(),
+/// it is replayed only when it differs from the one on screen
 ///
 class QtCanvas : public QWidget, public Canvas {
 
@@ -21,6 +38,49 @@ class QtCanvas : public QWidget, public Canvas {
   QPoint mouse;
   Qt::MouseButton mouseButton{Qt::NoButton};
   char keyP{'\0'};
+  QHash<QRgb, QBrush> brushes; // brushes are reused between fill() calls
+  QVector<QRect> batch;        // reused storage for rects()
+  TextCache m_text_cache;      // layouts of the strings drawn by text()
+  bool m_partial{false};
+  bool m_full{true}; // the backing pixmap must be painted entirely
+  QPixmap m_backing;
+  QRegion m_dirty; // areas to repaint at the next frame
+
+  std::mutex m_post_mutex;
+  bool m_has_posted{false};
+  std::shared_ptr<const DisplayList> m_posted; // guarded by m_post_mutex
+  std::shared_ptr<const DisplayList> m_scene;  // on screen, GUI thread only
+
+  void drawFrame(QPainter &painter) {
+    m_painter = &painter;
+    if (m_scene) {
+      m_scene->replay(*this);
+    } else {
+      m_app->draw(*this);
+    }
+    m_painter = nullptr;
+  }
+
+  // take the posted list, true when the frame changes
+  bool takePosted() {
+    std::lock_guard<std::mutex> lock(m_post_mutex);
+    if (!m_has_posted) {
+      return false;
+    }
+    m_has_posted = false;
+    const bool same = m_posted == m_scene ||
+                      (m_posted && m_scene && *m_posted == *m_scene);
+    m_scene = std::move(m_posted);
+    return !same;
+  }
+
+  const QBrush &brush(const QColor &color) {
+    auto it = brushes.find(color.rgb());
+    if (it == brushes.end()) {
+      it = brushes.insert(color.rgb(), QBrush{color});
+    }
+    return *it;
+  }
 
   // Canvas interface
 public:
@@ -51,8 +111,12 @@ public:
 
   void stroke(int r, int g, int b) override {
     ThrowIfNotDrawing();
-    QPen pen{QColor{r, g, b}};
-    m_painter->setPen(pen);
+    const QColor color{r, g, b};
+    const QPen &current = m_painter->pen();
+    if (current.style() == Qt::SolidLine && current.color() == color) {
+      return;
+    }
+    m_painter->setPen(color);
   }
 
   void noStroke() override {
@@ -66,21 +130,42 @@ public:
 
   void fill(int r, int g, int b) override {
     ThrowIfNotDrawing();
-    m_painter->setBrush(QBrush{QColor{r, g, b}});
+    const QColor color{r, g, b};
+    const QBrush &current = m_painter->brush();
+    if (current.style() == Qt::SolidPattern && current.color() == color) {
+      return;
+    }
+    m_painter->setBrush(brush(color));
   }
   void noFill() override {
     ThrowIfNotDrawing();
     m_painter->setBrush(QBrush{});
   }
   void rect(int x, int y, int w, int h) override {
-    m_painter->fillRect(x, y, w, h, m_painter->brush());
+    ThrowIfNotDrawing();
+    // drawRect fills with the current brush and outlines with the current pen
     m_painter->drawRect(x, y, w, h);
   }
 
+  void rects(const std::vector<Rect> &rects) override {
+    ThrowIfNotDrawing();
+    batch.resize(0);
+    batch.reserve(static_cast<int>(rects.size()));
+    for (const auto &r : rects) {
+      batch.append(QRect{r.x, r.y, r.w, r.h});
+    }
+    m_painter->drawRects(batch);
+  }
+
   void text(std::string str, int x, int y) override {
-    m_painter->drawText(x, y, QString::fromStdString(str));
+    ThrowIfNotDrawing();
+    const auto cached = m_text_cache.get(str, m_painter->font());
+    m_painter->drawStaticText(QPointF(x, y - cached.ascent), cached.text);
   }
 
+  /// hits and misses of the text() layouts
+  const TextCache &textCache() const { return m_text_cache; }
+
   void noLoop() override { timer.stop(); }
 
   int mouseX() const override { return mouse.x(); }
@@ -91,14 +176,75 @@ public:
 
   char key() const override { return keyP; }
 
+  void partialRepaint(bool enabled) override {
+    m_partial = enabled;
+    m_full = true;
+    m_backing = QPixmap{};
+    m_dirty = QRegion{};
+    update();
+  }
+  void redraw(const Rect &area) override {
+    m_dirty += QRect{area.x, area.y, area.w, area.h};
+  }
+  bool fullRedraw() const override { return !m_partial || m_full; }
+
+  ///
+  /// \brief post shows list from the next frame on, instead of calling the
+  /// application draw(); nullptr goes back to draw()
+  /// can be called from any thread
+  ///
+  void post(std::shared_ptr<const DisplayList> list) {
+    std::lock_guard<std::mutex> lock(m_post_mutex);
+    m_posted = std::move(list);
+    m_has_posted = true;
+  }
+
+  /// called by the timer
+  void refresh() {
+    const bool changed = takePosted();
+    if (changed) {
+      m_full = true;
+    }
+    if (m_scene) {
+      // an unchanged list leaves the widget as it is
+      if (changed) {
+        update();
+      }
+    } else if (!m_partial) {
+      update();
+    } else if (!m_dirty.isEmpty()) {
+      update(m_dirty);
+    }
+  }
+
 protected:
   void paintEvent(QPaintEvent *) override {
-    QPainter painter(this);
-    m_painter = &painter;
+    if (!m_partial) {
+      QPainter painter(this);
+      drawFrame(painter);
+      return;
+    }
 
-    m_app->draw(*this);
+    const qreal ratio = devicePixelRatioF();
+    if (m_backing.size() != QWidget::size() * ratio) {
+      m_backing = QPixmap{QWidget::size() * ratio};
+      m_backing.setDevicePixelRatio(ratio);
+      m_full = true;
+    }
 
-    m_painter = nullptr;
+    // redraw() calls made while drawing are for the next frame
+    const QRegion dirty = std::exchange(m_dirty, QRegion{});
+    if (m_full || !dirty.isEmpty()) {
+      QPainter painter(&m_backing);
+      if (!m_full) {
+        painter.setClipRegion(dirty);
+      }
+      drawFrame(painter);
+      m_full = false;
+    }
+
+    // the widget painter is clipped to the area Qt asks for
+    QPainter(this).drawPixmap(0, 0, m_backing);
   }
   void mousePressEvent(QMouseEvent *event) override {
     mouseButton = event->button();
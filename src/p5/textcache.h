@@ -0,0 +1,113 @@
+#pragma once
+
+#include <QFont>
+#include <QFontMetrics>
+#include <QStaticText>
+#include <QString>
+#include <QTransform>
+
+#include <cstdint>
+#include <functional>
+#include <list>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+///
+/// \brief The TextCache class keeps the layout of drawn strings: a prepared
+/// QStaticText per (string, font), so that a string drawn again is neither
+/// converted to QString nor laid out
+/// the cache holds at most capacity strings, the least recently drawn is
+/// dropped first
+///
+class TextCache {
+public:
+  struct Text {
+    const QStaticText &text;
+    int ascent; // drawText() places the baseline, drawStaticText() the top
+  };
+
+  explicit TextCache(std::size_t capacity = 1024) : m_capacity(capacity) {}
+
+  /// prepared text of str drawn with font
+  Text get(const std::string &str, const QFont &font) {
+    const int font_id = fontId(font);
+    Key key{font_id, str};
+    auto it = m_index.find(key);
+    if (it != m_index.end()) {
+      m_hits++;
+      m_entries.splice(m_entries.begin(), m_entries, it->second);
+      return {it->second->text, m_fonts[font_id].ascent};
+    }
+
+    m_misses++;
+    if (m_entries.size() >= m_capacity && !m_entries.empty()) {
+      m_index.erase(m_entries.back().key);
+      m_entries.pop_back();
+    }
+    QStaticText text(QString::fromStdString(str));
+    text.setPerformanceHint(QStaticText::AggressiveCaching);
+    text.prepare(QTransform{}, font);
+    m_entries.push_front(Entry{key, std::move(text)});
+    m_index.emplace(std::move(key), m_entries.begin());
+    return {m_entries.front().text, m_fonts[font_id].ascent};
+  }
+
+  std::size_t size() const { return m_entries.size(); }
+  std::size_t capacity() const { return m_capacity; }
+
+  std::uint64_t hits() const { return m_hits; }
+  std::uint64_t misses() const { return m_misses; }
+  double hitRate() const {
+    const auto total = m_hits + m_misses;
+    return total ? double(m_hits) / total : 0.0;
+  }
+
+  void clear() {
+    m_entries.clear();
+    m_index.clear();
+    m_fonts.clear();
+    m_hits = 0;
+    m_misses = 0;
+  }
+
+private:
+  struct Key {
+    int font;
+    std::string str;
+    bool operator==(const Key &other) const {
+      return font == other.font && str == other.str;
+    }
+  };
+  struct KeyHash {
+    std::size_t operator()(const Key &key) const {
+      return std::hash<std::string>{}(key.str) ^
+             (static_cast<std::size_t>(key.font) * 0x9e3779b97f4a7c15ull);
+    }
+  };
+  struct Entry {
+    Key key;
+    QStaticText text;
+  };
+  struct Font {
+    QFont font;
+    int ascent;
+  };
+
+  std::size_t m_capacity;
+  std::list<Entry> m_entries; // most recently drawn first
+  std::unordered_map<Key, std::list<Entry>::iterator, KeyHash> m_index;
+  std::vector<Font> m_fonts; // a canvas uses a handful of fonts
+  std::uint64_t m_hits{0};
+  std::uint64_t m_misses{0};
+
+  int fontId(const QFont &font) {
+    for (std::size_t i = 0; i < m_fonts.size(); i++) {
+      if (m_fonts[i].font == font) {
+        return static_cast<int>(i);
+      }
+    }
+    m_fonts.push_back(Font{font, QFontMetrics(font).ascent()});
+    return static_cast<int>(m_fonts.size() - 1);
+  }
+};
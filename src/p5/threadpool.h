@@ -0,0 +1,118 @@
+#pragma once
+
+#include <algorithm>
+#include <condition_variable>
+#include <deque>
+#include <exception>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+///
+/// \brief The ThreadPool class runs tasks on a fixed set of threads
+/// tasks must not wait on other tasks of the same pool
+///
+class ThreadPool {
+public:
+  explicit ThreadPool(std::size_t threads = defaultSize()) {
+    for (std::size_t i = 0; i < std::max<std::size_t>(threads, 1); i++) {
+      m_workers.emplace_back([this]() { run(); });
+    }
+  }
+
+  ~ThreadPool() {
+    {
+      std::lock_guard<std::mutex> lock(m_mutex);
+      m_stop = true;
+    }
+    m_cond.notify_all();
+    for (auto &worker : m_workers) {
+      worker.join();
+    }
+  }
+
+  ThreadPool(const ThreadPool &) = delete;
+  ThreadPool &operator=(const ThreadPool &) = delete;
+
+  std::size_t size() const { return m_workers.size(); }
+
+  static std::size_t defaultSize() {
+    return std::max(1u, std::thread::hardware_concurrency());
+  }
+
+  ///
+  /// \brief parallelFor calls fn(begin, end) on consecutive chunks covering
+  /// [0, count) and returns when all chunks are done
+  /// the first exception thrown by fn is rethrown
+  ///
+  void parallelFor(std::size_t count,
+                   const std::function<void(std::size_t, std::size_t)> &fn,
+                   std::size_t chunks = 0) {
+    if (count == 0) {
+      return;
+    }
+    if (chunks == 0) {
+      chunks = size();
+    }
+    chunks = std::min(chunks, count);
+
+    std::mutex mutex;
+    std::condition_variable done;
+    std::size_t pending = chunks;
+    std::exception_ptr error;
+
+    {
+      std::lock_guard<std::mutex> lock(m_mutex);
+      for (std::size_t c = 0; c < chunks; c++) {
+        const std::size_t begin = count * c / chunks;
+        const std::size_t end = count * (c + 1) / chunks;
+        m_tasks.emplace_back([&, begin, end]() {
+          std::exception_ptr e;
+          try {
+            fn(begin, end);
+          } catch (...) {
+            e = std::current_exception();
+          }
+          std::lock_guard<std::mutex> lock(mutex);
+          if (e && !error) {
+            error = e;
+          }
+          if (--pending == 0) {
+            done.notify_one();
+          }
+        });
+      }
+    }
+    m_cond.notify_all();
+
+    std::unique_lock<std::mutex> lock(mutex);
+    done.wait(lock, [&pending]() { return pending == 0; });
+    if (error) {
+      std::rethrow_exception(error);
+    }
+  }
+
+private:
+  void run() {
+    for (;;) {
+      std::function<void()> task;
+      {
+        std::unique_lock<std::mutex> lock(m_mutex);
+        m_cond.wait(lock, [this]() { return m_stop || !m_tasks.empty(); });
+        if (m_tasks.empty()) {
+          return;
+        }
+        task = std::move(m_tasks.front());
+        m_tasks.pop_front();
+      }
+      task();
+    }
+  }
+
+  std::vector<std::thread> m_workers;
+  std::deque<std::function<void()>> m_tasks;
+  std::mutex m_mutex;
+  std::condition_variable m_cond;
+  bool m_stop{false};
+};
@@ -0,0 +1,188 @@
+#pragma once
+
+#include <cstdint>
+#include <vector>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#define PHYSICS_X86 1
+#endif
+
+///
+/// \brief The BirdLanes struct holds the state of many birds contiguously,
+/// one lane per bird
+///
+struct BirdLanes {
+  std::vector<int> x;
+  std::vector<int> y;
+  std::vector<int> velocity;
+  std::vector<int> score;
+  std::vector<std::uint8_t> flap; // input, 1 when the bird flaps this tick
+  std::vector<std::uint8_t> dead; // output of stepBirds
+
+  std::size_t size() const { return x.size(); }
+
+  void resize(std::size_t n) {
+    x.resize(n);
+    y.resize(n);
+    velocity.resize(n);
+    score.resize(n);
+    flap.resize(n);
+    dead.resize(n);
+  }
+};
+
+///
+/// \brief The PhysicsRules struct holds the constants shared by all birds
+///
+struct PhysicsRules {
+  int gravity{1};
+  int lift{-10};
+  int radius{10};
+  int screen_height{0};
+};
+
+///
+/// \brief The PipeLanes struct gives the closest pipe of each lane
+/// with a single entry, the pipe is shared by all lanes
+///
+struct PipeLanes {
+  std::vector<int> x;
+  std::vector<int> top;
+  int width{20};
+  int gate{100};
+
+  bool shared() const { return x.size() == 1; }
+};
+
+namespace physics {
+
+// one bird, same rules as Bird::up, Bird::update, Bird::offscreen and
+// Bird::hits
+inline std::uint8_t stepLane(int &x, int &y, int &velocity, int &score,
+                             bool flap, int pipe_x, int pipe_top,
+                             const PipeLanes &pipe, const PhysicsRules &rules) {
+  if (flap) {
+    velocity = rules.lift;
+  }
+  score++;
+  velocity += rules.gravity;
+  y += velocity;
+
+  const bool offscreen = y < 0 || y + rules.radius > rules.screen_height;
+  const bool hits = !(x > pipe_x + pipe.width || x + rules.radius < pipe_x) &&
+                    !(y > pipe_top && y + rules.radius < pipe_top + pipe.gate);
+  return offscreen || hits;
+}
+
+inline void stepScalar(BirdLanes &b, const PhysicsRules &rules,
+                       const PipeLanes &pipe, std::size_t begin,
+                       std::size_t end) {
+  const bool shared = pipe.shared();
+  for (std::size_t i = begin; i < end; i++) {
+    const std::size_t p = shared ? 0 : i;
+    b.dead[i] = stepLane(b.x[i], b.y[i], b.velocity[i], b.score[i], b.flap[i],
+                         pipe.x[p], pipe.top[p], pipe, rules);
+  }
+}
+
+#ifdef PHYSICS_X86
+__attribute__((target("avx2"))) inline __m256i load8(const int *p) {
+  return _mm256_loadu_si256(reinterpret_cast<const __m256i *>(p));
+}
+
+__attribute__((target("avx2"))) inline void store8(int *p, __m256i v) {
+  _mm256_storeu_si256(reinterpret_cast<__m256i *>(p), v);
+}
+
+// returns the number of lanes processed, the remainder is left to the scalar
+// loop
+__attribute__((target("avx2"))) inline std::size_t
+stepAvx2(BirdLanes &b, const PhysicsRules &rules, const PipeLanes &pipe) {
+  const std::size_t n = b.size() / 8 * 8;
+  const bool shared = pipe.shared();
+
+  const __m256i zero = _mm256_setzero_si256();
+  const __m256i one = _mm256_set1_epi32(1);
+  const __m256i lift = _mm256_set1_epi32(rules.lift);
+  const __m256i gravity = _mm256_set1_epi32(rules.gravity);
+  const __m256i radius = _mm256_set1_epi32(rules.radius);
+  const __m256i height = _mm256_set1_epi32(rules.screen_height);
+  const __m256i width = _mm256_set1_epi32(pipe.width);
+  const __m256i gate = _mm256_set1_epi32(pipe.gate);
+  __m256i px = _mm256_set1_epi32(pipe.x[0]);
+  __m256i ptop = _mm256_set1_epi32(pipe.top[0]);
+
+  for (std::size_t i = 0; i < n; i += 8) {
+    if (!shared) {
+      px = load8(&pipe.x[i]);
+      ptop = load8(&pipe.top[i]);
+    }
+    const __m256i x = load8(&b.x[i]);
+    __m256i y = load8(&b.y[i]);
+    __m256i velocity = load8(&b.velocity[i]);
+    __m256i score = load8(&b.score[i]);
+
+    const __m256i flap = _mm256_cmpgt_epi32(
+        _mm256_cvtepu8_epi32(
+            _mm_loadl_epi64(reinterpret_cast<const __m128i *>(&b.flap[i]))),
+        zero);
+
+    velocity = _mm256_blendv_epi8(velocity, lift, flap);
+    score = _mm256_add_epi32(score, one);
+    velocity = _mm256_add_epi32(velocity, gravity);
+    y = _mm256_add_epi32(y, velocity);
+
+    const __m256i y_bottom = _mm256_add_epi32(y, radius);
+    const __m256i offscreen = _mm256_or_si256(
+        _mm256_cmpgt_epi32(zero, y), _mm256_cmpgt_epi32(y_bottom, height));
+
+    // horizontal overlap: !(x > px + width || x + radius < px)
+    const __m256i apart_x = _mm256_or_si256(
+        _mm256_cmpgt_epi32(x, _mm256_add_epi32(px, width)),
+        _mm256_cmpgt_epi32(px, _mm256_add_epi32(x, radius)));
+    // inside the gate: y > top && y + radius < top + gate
+    const __m256i in_gate = _mm256_and_si256(
+        _mm256_cmpgt_epi32(y, ptop),
+        _mm256_cmpgt_epi32(_mm256_add_epi32(ptop, gate), y_bottom));
+    const __m256i hits =
+        _mm256_andnot_si256(_mm256_or_si256(apart_x, in_gate),
+                            _mm256_cmpeq_epi32(zero, zero));
+
+    const __m256i dead = _mm256_or_si256(offscreen, hits);
+    const int mask = _mm256_movemask_ps(_mm256_castsi256_ps(dead));
+
+    store8(&b.y[i], y);
+    store8(&b.velocity[i], velocity);
+    store8(&b.score[i], score);
+    for (int k = 0; k < 8; k++) {
+      b.dead[i + k] = (mask >> k) & 1;
+    }
+  }
+  return n;
+}
+
+inline bool hasAvx2() {
+  static const bool avx2 = __builtin_cpu_supports("avx2");
+  return avx2;
+}
+#endif
+
+} // namespace physics
+
+///
+/// \brief stepBirds advances all lanes by one tick and fills the death mask
+/// flapping birds take the lift velocity, then gravity applies, then the bird
+/// dies when offscreen or hitting its closest pipe
+/// uses AVX2 when the cpu supports it
+///
+inline void stepBirds(BirdLanes &birds, const PhysicsRules &rules,
+                      const PipeLanes &pipe) {
+  std::size_t done = 0;
+#ifdef PHYSICS_X86
+  if (physics::hasAvx2()) {
+    done = physics::stepAvx2(birds, rules, pipe);
+  }
+#endif
+  physics::stepScalar(birds, rules, pipe, done, birds.size());
+}
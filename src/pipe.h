@@ -1,7 +1,23 @@
 #pragma once
 
 #include "p5/application.h"
-#include "p5/grid.h"
+
+#include <cstdint>
+#include <random>
+
+///
+/// \brief The Course struct generates the pipe sequence of an episode
+/// two courses with the same seed produce the same pipes
+///
+struct Course {
+  std::uint32_t seed;
+  std::mt19937 rng;
+
+  explicit Course(std::uint32_t seed = 0) : seed{seed}, rng{seed} {}
+
+  // modulo instead of a distribution, to stay identical across std libraries
+  int random(int max) { return static_cast<int>(rng() % max); }
+};
 
 struct Pipe {
 
@@ -11,9 +27,9 @@ struct Pipe {
   int top{-1};
   bool closest = false;
 
-  Pipe(int screen_width, int screen_height, int pipe_width) {
+  Pipe(int screen_width, int screen_height, int pipe_width, Course &course) {
     x = screen_width;
-    top = random(screen_height - gate);
+    top = course.random(screen_height - gate);
     width = pipe_width;
   }
 
@@ -21,11 +37,21 @@ struct Pipe {
 
   bool offscreen() const { return x + width < 0; }
 
-  static void draw(const Pipe &pipe, Canvas &canvas) {
-
-    canvas.fill((pipe.closest) ? 50 : 0, 0, 0);
-
-    canvas.rect(pipe.x, 0, pipe.width, pipe.top);
-    canvas.rect(pipe.x, pipe.top + pipe.gate, pipe.width, canvas.height());
+  template <typename Pipes>
+  static void draw(const Pipes &pipes, Canvas &canvas) {
+    // one batch per fill color
+    std::vector<Rect> rects[2];
+
+    for (const Pipe &pipe : pipes) {
+      auto &batch = rects[pipe.closest];
+      batch.push_back({pipe.x, 0, pipe.width, pipe.top});
+      batch.push_back(
+          {pipe.x, pipe.top + pipe.gate, pipe.width, canvas.height()});
+    }
+
+    canvas.fill(0, 0, 0);
+    canvas.rects(rects[false]);
+    canvas.fill(50, 0, 0);
+    canvas.rects(rects[true]);
   }
 };
\ No newline at end of file
@@ -0,0 +1,145 @@
+#pragma once
+
+#include "episodecache.h"
+#include "neuralnetwork/nn.h"
+#include "p5/threadpool.h"
+#include "vectorenv.h"
+
+#include <atomic>
+#include <unordered_map>
+
+///
+/// \brief The RolloutResult struct gives the mean score of each brain and
+/// the number of bird ticks simulated to get them
+///
+struct RolloutResult {
+  std::vector<double> scores;
+  long ticks{0};
+};
+
+/// same decision as Bird::think
+inline bool decide(const NeuralNetwork &brain, const double *observation) {
+  // buffers reused by the calls of a thread
+  static thread_local std::vector<double> input;
+  static thread_local std::vector<double> output;
+  input.assign(observation, observation + VectorEnv::ObservationSize);
+  brain.predict(input, output);
+  return output[0] > output[1];
+}
+
+///
+/// \brief rollout plays every brain on every course seed until its bird dies
+/// chunks of brains run in parallel, each chunk in one VectorEnv
+///
+inline RolloutResult rollout(const std::vector<NeuralNetwork> &brains,
+                             const std::vector<std::uint32_t> &seeds,
+                             const VectorEnv::Config &config,
+                             ThreadPool &pool) {
+  RolloutResult result;
+  result.scores.resize(brains.size());
+  std::atomic<long> ticks{0};
+
+  pool.parallelFor(brains.size(), [&](std::size_t begin, std::size_t end) {
+    // world w plays brain begin + w / seeds.size() on seeds[w % seeds.size()]
+    const std::size_t n = seeds.size();
+    VectorEnv env((end - begin) * n, config);
+
+    std::vector<std::uint32_t> world_seeds;
+    for (std::size_t b = begin; b < end; b++) {
+      world_seeds.insert(world_seeds.end(), seeds.begin(), seeds.end());
+    }
+    env.reset(world_seeds);
+
+    std::vector<std::uint8_t> actions(env.size(), 0);
+    while (!env.allDone()) {
+      for (std::size_t w = 0; w < env.size(); w++) {
+        if (!env.done(w)) {
+          actions[w] = decide(brains[begin + w / n], env.observation(w));
+        }
+      }
+      env.step(actions);
+    }
+
+    for (std::size_t w = 0; w < env.size(); w++) {
+      result.scores[begin + w / n] += env.score(w) / double(n);
+    }
+    ticks += env.ticks();
+  });
+
+  result.ticks = ticks;
+  return result;
+}
+
+///
+/// \brief cachedEvaluate gives the same result as evaluate(brains, seeds)
+/// but only plays the (brain, seed) pairs missing from the cache, identical
+/// brains of the population are played once
+/// the cache must be cleared when the game config changes
+/// the ticks of the result only count the ticks actually simulated
+///
+template <typename Evaluate>
+RolloutResult cachedEvaluate(const std::vector<NeuralNetwork> &brains,
+                             const std::vector<std::uint32_t> &seeds,
+                             EpisodeCache &cache, Evaluate &&evaluate) {
+  RolloutResult result;
+  result.scores.resize(brains.size());
+
+  std::vector<std::uint64_t> hashes;
+  hashes.reserve(brains.size());
+  for (const auto &brain : brains) {
+    hashes.push_back(brain.hash());
+  }
+
+  for (auto seed : seeds) {
+    // brain i scores played_scores[source[i]] when played, else cached[i]
+    std::unordered_map<std::uint64_t, std::size_t> missing;
+    std::vector<NeuralNetwork> played;
+    std::vector<std::size_t> source(brains.size(), 0);
+    std::vector<double> cached(brains.size(), 0.0);
+    std::vector<bool> hit(brains.size(), false);
+    for (std::size_t i = 0; i < brains.size(); i++) {
+      auto it = missing.find(hashes[i]);
+      if (it != missing.end()) {
+        source[i] = it->second;
+      } else if (auto entry = cache.find({hashes[i], seed})) {
+        hit[i] = true;
+        cached[i] = entry->score;
+      } else {
+        source[i] = played.size();
+        missing.emplace(hashes[i], played.size());
+        played.push_back(brains[i]);
+      }
+    }
+
+    std::vector<double> played_scores;
+    if (!played.empty()) {
+      RolloutResult scores = evaluate(played, {seed});
+      result.ticks += scores.ticks;
+      played_scores = std::move(scores.scores);
+      for (const auto &[hash, index] : missing) {
+        // a bird scores one point per tick survived
+        const double score = played_scores[index];
+        cache.insert({hash, seed}, {score, static_cast<long>(score)});
+      }
+    }
+
+    for (std::size_t i = 0; i < brains.size(); i++) {
+      const double score = hit[i] ? cached[i] : played_scores[source[i]];
+      result.scores[i] += score / seeds.size();
+    }
+  }
+  return result;
+}
+
+/// rollout consulting the cache first
+inline RolloutResult cachedRollout(const std::vector<NeuralNetwork> &brains,
+                                   const std::vector<std::uint32_t> &seeds,
+                                   const VectorEnv::Config &config,
+                                   ThreadPool &pool, EpisodeCache &cache) {
+  return cachedEvaluate(
+      brains, seeds, cache,
+      [&](const std::vector<NeuralNetwork> &played,
+          const std::vector<std::uint32_t> &played_seeds) {
+        return rollout(played, played_seeds, config, pool);
+      });
+}
@@ -0,0 +1,455 @@
+#pragma once
+#include "boardgenerator.h"
+#include "minefield.h"
+#include "p5/threadpool.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <deque>
+#include <vector>
+
+///
+/// headless minesweeper player: it clicks through Minefield::reveal and
+/// Minefield::mark like a player would, without looking at hidden cells
+///
+namespace solver {
+
+struct Result {
+  bool won{false};
+  int moves{0};   // reveals and marks
+  int guesses{0}; // reveals of cells not proven safe
+};
+
+///
+/// \brief The Solver class plays one board
+/// - constraint propagation: a revealed number whose mines are all marked
+///   reveals its other hidden neighbors, a number with as many hidden
+///   neighbors as missing mines marks them all
+/// - when propagation is stuck, the frontier (hidden cells next to numbers)
+///   is split in independent components whose mine configurations are
+///   enumerated, weighted by the ways to place the remaining mines on the
+///   other hidden cells: cells safe or mined in every configuration are
+///   played, else the cell with the lowest mine probability is guessed
+///
+class Solver {
+public:
+  /// components above this number of cells are not enumerated, their cells
+  /// get the probability of their most constrained number
+  static constexpr std::size_t MaxEnumeration = 24;
+
+  Solver(Minefield &field, std::uint64_t seed)
+      : m_field(field), m_random(seed), m_queued(field.cellCount()) {}
+
+  Result play(Position first_click) {
+    open(m_field.planes().index(first_click));
+    while (!m_field.finished()) {
+      if (!propagate() && !enumerate()) {
+        break;
+      }
+    }
+    m_result.won = m_field.won();
+    return m_result;
+  }
+
+private:
+  struct Component {
+    std::vector<std::size_t> cells;
+    std::vector<std::vector<std::size_t>> constraints; // local cell indices
+    std::vector<int> missing; // mines missing around each constraint
+    std::vector<double> solutions;                // per number of mines
+    std::vector<std::vector<double>> cell_mines;  // per number of mines
+  };
+
+  Minefield &m_field;
+  board::Random m_random;
+  BitPlane m_queued; // numbers waiting in m_work
+  std::deque<std::size_t> m_work;
+  Result m_result;
+
+  const BitPlane &plane(Minefield::Flag flag) const {
+    return m_field.planes().flags(flag);
+  }
+  bool hidden(std::size_t id) const {
+    return !plane(Minefield::Revealed).test(id) &&
+           !plane(Minefield::Marked).test(id);
+  }
+  int number(std::size_t id) const {
+    return m_field.planes().counts(Minefield::NeighborMines).get(id);
+  }
+
+  template <typename F> void forEachNeighbor(std::size_t id, F &&cb) const {
+    forEachNeighborIndex<EightNeighbors>(
+        m_field.size(), m_field.planes().position(id), cb);
+  }
+
+  void enqueue(std::size_t id) {
+    if (plane(Minefield::Revealed).test(id) && number(id) > 0 &&
+        !m_queued.test(id)) {
+      m_queued.set(id);
+      m_work.push_back(id);
+    }
+  }
+
+  // a revealed or marked cell changes the constraints of its neighbors
+  void changed(std::size_t id) {
+    enqueue(id);
+    forEachNeighbor(id, [this](std::size_t n) { enqueue(n); });
+  }
+
+  void open(std::size_t id) {
+    m_result.moves++;
+    m_field.reveal(m_field.planes().position(id),
+                   [this](std::size_t revealed) { changed(revealed); });
+  }
+
+  void flag(std::size_t id) {
+    m_result.moves++;
+    m_field.mark(m_field.planes().position(id));
+    changed(id);
+  }
+
+  /// returns true when a cell was revealed or marked
+  bool propagate() {
+    bool progress = false;
+    std::vector<std::size_t> unknown;
+    while (!m_work.empty() && !m_field.finished()) {
+      const std::size_t id = m_work.front();
+      m_work.pop_front();
+      m_queued.reset(id);
+
+      int marked = 0;
+      unknown.clear();
+      forEachNeighbor(id, [&](std::size_t n) {
+        if (plane(Minefield::Marked).test(n)) {
+          marked++;
+        } else if (!plane(Minefield::Revealed).test(n)) {
+          unknown.push_back(n);
+        }
+      });
+      if (unknown.empty()) {
+        continue;
+      }
+
+      const int missing = number(id) - marked;
+      if (missing == 0) {
+        for (auto n : unknown) {
+          open(n);
+        }
+        progress = true;
+      } else if (missing == static_cast<int>(unknown.size())) {
+        for (auto n : unknown) {
+          flag(n);
+        }
+        progress = true;
+      }
+    }
+    return progress;
+  }
+
+  void enumerate(Component &c, std::vector<int> &assignment,
+                 std::vector<int> &placed, std::vector<int> &left,
+                 const std::vector<std::vector<std::size_t>> &cell_constraints,
+                 std::size_t v, int mines) {
+    if (v == c.cells.size()) {
+      c.solutions[mines] += 1;
+      for (std::size_t i = 0; i < c.cells.size(); i++) {
+        c.cell_mines[mines][i] += assignment[i];
+      }
+      return;
+    }
+    for (int value : {0, 1}) {
+      bool feasible = true;
+      for (auto k : cell_constraints[v]) {
+        placed[k] += value;
+        left[k]--;
+        feasible = feasible && placed[k] <= c.missing[k] &&
+                   placed[k] + left[k] >= c.missing[k];
+      }
+      if (feasible) {
+        assignment[v] = value;
+        enumerate(c, assignment, placed, left, cell_constraints, v + 1,
+                  mines + value);
+      }
+      for (auto k : cell_constraints[v]) {
+        placed[k] -= value;
+        left[k]++;
+      }
+    }
+  }
+
+  void enumerate(Component &c) {
+    std::vector<std::vector<std::size_t>> cell_constraints(c.cells.size());
+    std::vector<int> left(c.constraints.size());
+    for (std::size_t k = 0; k < c.constraints.size(); k++) {
+      for (auto v : c.constraints[k]) {
+        cell_constraints[v].push_back(k);
+      }
+      left[k] = static_cast<int>(c.constraints[k].size());
+    }
+    std::vector<int> placed(c.constraints.size(), 0);
+    std::vector<int> assignment(c.cells.size(), 0);
+    c.solutions.assign(c.cells.size() + 1, 0.0);
+    c.cell_mines.assign(c.cells.size() + 1,
+                        std::vector<double>(c.cells.size(), 0.0));
+    enumerate(c, assignment, placed, left, cell_constraints, 0, 0);
+  }
+
+  static std::vector<double> convolve(const std::vector<double> &a,
+                                      const std::vector<double> &b) {
+    std::vector<double> r(a.size() + b.size() - 1, 0.0);
+    for (std::size_t i = 0; i < a.size(); i++) {
+      for (std::size_t j = 0; j < b.size(); j++) {
+        r[i + j] += a[i] * b[j];
+      }
+    }
+    return r;
+  }
+
+  static double logChoose(double n, double k) {
+    return std::lgamma(n + 1) - std::lgamma(k + 1) - std::lgamma(n - k + 1);
+  }
+
+  /// returns true when a cell was revealed or marked
+  bool enumerate() {
+    const std::size_t cells = m_field.cellCount();
+    const BitPlane &revealed = plane(Minefield::Revealed);
+
+    // frontier cells in components, linked through the numbers they share
+    std::vector<int> component_of(cells, -1);
+    std::vector<Component> components;
+    std::vector<double> local(cells, 0.0); // most constrained number ratio
+    std::vector<std::size_t> numbers;
+    for (std::size_t id = 0; id < cells; id++) {
+      if (!revealed.test(id) || number(id) == 0) {
+        continue;
+      }
+      bool frontier = false;
+      forEachNeighbor(id, [&](std::size_t n) {
+        frontier = frontier || hidden(n);
+      });
+      if (frontier) {
+        numbers.push_back(id);
+      }
+    }
+
+    for (auto start : numbers) {
+      // breadth first over numbers and cells, from a number not yet used
+      bool used = false;
+      forEachNeighbor(start, [&](std::size_t n) {
+        used = used || (hidden(n) && component_of[n] >= 0);
+      });
+      if (used) {
+        continue;
+      }
+      const int c = static_cast<int>(components.size());
+      components.emplace_back();
+      std::deque<std::size_t> todo{start};
+      std::vector<std::size_t> seen_numbers{start};
+      while (!todo.empty()) {
+        const std::size_t id = todo.front();
+        todo.pop_front();
+        forEachNeighbor(id, [&](std::size_t n) {
+          if (!hidden(n) || component_of[n] >= 0) {
+            return;
+          }
+          component_of[n] = c;
+          components[c].cells.push_back(n);
+          forEachNeighbor(n, [&](std::size_t m) {
+            if (revealed.test(m) && number(m) > 0 &&
+                std::find(seen_numbers.begin(), seen_numbers.end(), m) ==
+                    seen_numbers.end()) {
+              seen_numbers.push_back(m);
+              todo.push_back(m);
+            }
+          });
+        });
+      }
+
+      // constraints of the component, in local cell indices
+      auto &component = components[c];
+      for (auto id : seen_numbers) {
+        int marked = 0;
+        std::vector<std::size_t> vars;
+        forEachNeighbor(id, [&](std::size_t n) {
+          if (plane(Minefield::Marked).test(n)) {
+            marked++;
+          } else if (hidden(n)) {
+            vars.push_back(static_cast<std::size_t>(
+                std::find(component.cells.begin(), component.cells.end(), n) -
+                component.cells.begin()));
+          }
+        });
+        if (vars.empty()) {
+          continue;
+        }
+        const int missing = number(id) - marked;
+        for (auto v : vars) {
+          local[component.cells[v]] =
+              std::max(local[component.cells[v]], double(missing) / vars.size());
+        }
+        component.constraints.push_back(std::move(vars));
+        component.missing.push_back(missing);
+      }
+    }
+
+    // the remaining mines, on the frontier or on the other hidden cells
+    const double remaining =
+        double(m_field.mineCount()) - plane(Minefield::Marked).count();
+    std::vector<std::size_t> others;
+    std::vector<Component *> enumerated;
+    for (std::size_t id = 0; id < cells; id++) {
+      if (hidden(id) && (component_of[id] < 0 ||
+                         components[component_of[id]].cells.size() >
+                             MaxEnumeration)) {
+        others.push_back(id);
+      }
+    }
+    for (auto &component : components) {
+      if (component.cells.size() <= MaxEnumeration) {
+        enumerate(component);
+        enumerated.push_back(&component);
+      }
+    }
+
+    // weight of t frontier mines: ways to place the others
+    const double other_cells = double(others.size());
+    auto log_weight = [&](std::size_t t) {
+      const double rest = remaining - double(t);
+      return rest < 0 || rest > other_cells ? -INFINITY
+                                            : logChoose(other_cells, rest);
+    };
+
+    std::vector<double> total{1.0};
+    for (auto *component : enumerated) {
+      total = convolve(total, component->solutions);
+    }
+    double max_log = -INFINITY;
+    for (std::size_t t = 0; t < total.size(); t++) {
+      if (total[t] > 0) {
+        max_log = std::max(max_log, log_weight(t));
+      }
+    }
+    auto weight = [&](std::size_t t) {
+      return std::isinf(max_log) ? 0.0 : std::exp(log_weight(t) - max_log);
+    };
+    double z = 0;
+    double other_mines = 0;
+    for (std::size_t t = 0; t < total.size(); t++) {
+      z += total[t] * weight(t);
+      other_mines += total[t] * weight(t) * (remaining - double(t));
+    }
+
+    // probabilities, certain cells are played at once
+    std::vector<std::pair<double, std::size_t>> candidates;
+    bool progress = false;
+    for (auto *component : enumerated) {
+      std::vector<double> rest{1.0};
+      for (auto *other : enumerated) {
+        if (other != component) {
+          rest = convolve(rest, other->solutions);
+        }
+      }
+      for (std::size_t v = 0; v < component->cells.size(); v++) {
+        double mine = 0;
+        double safe = 0;
+        for (std::size_t k = 0; k < component->solutions.size(); k++) {
+          double w = 0;
+          for (std::size_t t = 0; t < rest.size(); t++) {
+            w += rest[t] * weight(k + t);
+          }
+          mine += component->cell_mines[k][v] * w;
+          safe += (component->solutions[k] - component->cell_mines[k][v]) * w;
+        }
+        const std::size_t id = component->cells[v];
+        if (z > 0 && mine == 0) {
+          open(id);
+          progress = true;
+        } else if (z > 0 && safe == 0) {
+          flag(id);
+          progress = true;
+        } else {
+          candidates.emplace_back(z > 0 ? mine / z : local[id], id);
+        }
+      }
+    }
+    if (progress) {
+      return true;
+    }
+
+    const double other_probability =
+        z > 0 && other_cells > 0 ? other_mines / z / other_cells : 1.0;
+    for (auto id : others) {
+      candidates.emplace_back(
+          component_of[id] >= 0 ? local[id] : other_probability, id);
+    }
+    if (candidates.empty()) {
+      return false;
+    }
+
+    // guess the least likely mine, ties broken at random
+    double best = candidates.front().first;
+    for (const auto &candidate : candidates) {
+      best = std::min(best, candidate.first);
+    }
+    std::vector<std::size_t> ties;
+    for (const auto &candidate : candidates) {
+      if (candidate.first <= best + 1e-12) {
+        ties.push_back(candidate.second);
+      }
+    }
+    m_result.guesses++;
+    open(ties[m_random.below(ties.size())]);
+    return true;
+  }
+};
+
+struct Stats {
+  std::size_t boards{0};
+  std::size_t wins{0};
+  std::size_t guesses{0};
+  double seconds{0};
+
+  double winRate() const { return boards ? double(wins) / boards : 0.0; }
+  double boardsPerSecond() const { return seconds > 0 ? boards / seconds : 0; }
+};
+
+///
+/// \brief playBoards generates and plays boards of size with mines, the
+/// first click in the middle is safe; board i is the same for a seed
+/// whatever the pool
+///
+inline Stats playBoards(Size size, std::size_t mines, std::size_t boards,
+                        std::uint64_t seed, ThreadPool *pool = nullptr) {
+  std::vector<Result> results(boards);
+  const Position first_click{size.column / 2, size.row / 2};
+
+  auto play = [&](std::size_t begin, std::size_t end) {
+    for (std::size_t i = begin; i < end; i++) {
+      const std::uint64_t board_seed = seed + 0x9e3779b97f4a7c15ull * i;
+      auto field = board::generate(size, mines, board_seed, first_click);
+      results[i] = Solver(field, board_seed).play(first_click);
+    }
+  };
+
+  const auto start = std::chrono::steady_clock::now();
+  if (pool) {
+    pool->parallelFor(boards, play, pool->size() * 8);
+  } else {
+    play(0, boards);
+  }
+  const std::chrono::duration<double> elapsed =
+      std::chrono::steady_clock::now() - start;
+
+  Stats stats;
+  stats.boards = boards;
+  stats.seconds = elapsed.count();
+  for (const auto &result : results) {
+    stats.wins += result.won;
+    stats.guesses += result.guesses;
+  }
+  return stats;
+}
+
+} // namespace solver
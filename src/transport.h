@@ -0,0 +1,113 @@
+#pragma once
+
+#include <cerrno>
+#include <cstdint>
+#include <cstring>
+#include <stdexcept>
+#include <string>
+#include <utility>
+
+#include <sys/socket.h>
+#include <unistd.h>
+
+///
+/// \brief The Transport class exchanges fixed size messages between a
+/// coordinator and a worker
+///
+class Transport {
+public:
+  virtual ~Transport() = default;
+
+  /// send exactly size bytes
+  virtual void send(const void *data, std::size_t size) = 0;
+  /// receive exactly size bytes, returns false when the peer closed
+  /// the connection before the first byte
+  virtual bool receive(void *data, std::size_t size) = 0;
+
+  template <typename T> void send(const T &message) {
+    send(&message, sizeof(T));
+  }
+  template <typename T> bool receive(T &message) {
+    return receive(&message, sizeof(T));
+  }
+};
+
+///
+/// \brief The SocketTransport class is a Transport over a connected stream
+/// socket, local workers use a unix socket pair
+///
+class SocketTransport : public Transport {
+  int m_fd{-1};
+
+public:
+  explicit SocketTransport(int fd) : m_fd(fd) {}
+  ~SocketTransport() override { close(); }
+
+  SocketTransport(SocketTransport &&other) noexcept
+      : m_fd(std::exchange(other.m_fd, -1)) {}
+  SocketTransport &operator=(SocketTransport &&other) noexcept {
+    std::swap(m_fd, other.m_fd);
+    return *this;
+  }
+
+  /// two connected ends, one for each process
+  static std::pair<SocketTransport, SocketTransport> pair() {
+    int fds[2];
+    if (::socketpair(AF_UNIX, SOCK_STREAM, 0, fds) != 0) {
+      throw std::runtime_error(std::string("SocketTransport::pair; ") +
+                               std::strerror(errno));
+    }
+    return {SocketTransport(fds[0]), SocketTransport(fds[1])};
+  }
+
+  using Transport::receive;
+  using Transport::send;
+
+  int fd() const { return m_fd; }
+
+  void close() {
+    if (m_fd >= 0) {
+      ::close(m_fd);
+      m_fd = -1;
+    }
+  }
+
+  void send(const void *data, std::size_t size) override {
+    auto bytes = static_cast<const char *>(data);
+    while (size > 0) {
+      const ssize_t n = ::send(m_fd, bytes, size, MSG_NOSIGNAL);
+      if (n < 0 && errno == EINTR) {
+        continue;
+      }
+      if (n <= 0) {
+        throw std::runtime_error(std::string("SocketTransport::send; ") +
+                                 std::strerror(errno));
+      }
+      bytes += n;
+      size -= static_cast<std::size_t>(n);
+    }
+  }
+
+  bool receive(void *data, std::size_t size) override {
+    auto bytes = static_cast<char *>(data);
+    bool first = true;
+    while (size > 0) {
+      const ssize_t n = ::recv(m_fd, bytes, size, 0);
+      if (n < 0 && errno == EINTR) {
+        continue;
+      }
+      if (n == 0 && first) {
+        return false;
+      }
+      if (n <= 0) {
+        throw std::runtime_error(std::string("SocketTransport::receive; ") +
+                                 (n == 0 ? "connection closed"
+                                         : std::strerror(errno)));
+      }
+      first = false;
+      bytes += n;
+      size -= static_cast<std::size_t>(n);
+    }
+    return true;
+  }
+};
@@ -0,0 +1,205 @@
+#pragma once
+
+#include "physics.h"
+#include "pipe.h"
+
+#include <algorithm>
+#include <cstdint>
+#include <vector>
+
+///
+/// \brief The VectorEnv class steps N independent flappy bird worlds at once
+/// each world has one bird and its own course, worlds are reset together
+/// the tick is the same as flappy_bird's: pipes move, the bird decides from
+/// its observation, physics and collisions apply, then pipes are created
+///
+class VectorEnv {
+public:
+  /// same inputs as Bird::think
+  static constexpr int ObservationSize = 5;
+
+  struct Config {
+    int width{640};
+    int height{480};
+    int velocity{5};
+    int pipe_creation{75};
+    int pipe_width{50};
+    int pipe_gate{100};
+    int bird_x{20};
+    int max_score{0}; // worlds stop at this score, 0 for no limit
+  };
+
+  explicit VectorEnv(std::size_t worlds) : VectorEnv(worlds, Config{}) {}
+
+  VectorEnv(std::size_t worlds, Config config)
+      : m_config(config), m_courses(worlds), m_done(worlds),
+        m_final_score(worlds), m_observations(worlds * ObservationSize) {
+    m_lanes.resize(worlds);
+    m_rules.screen_height = config.height;
+    m_closest.width = config.pipe_width;
+    m_closest.gate = config.pipe_gate;
+    m_closest.x.resize(worlds);
+    m_closest.top.resize(worlds);
+  }
+
+  std::size_t size() const { return m_done.size(); }
+  const Config &config() const { return m_config; }
+
+  /// restart all worlds, world i runs on the course seeded with seeds[i]
+  void reset(const std::vector<std::uint32_t> &seeds) {
+    const std::size_t n = size();
+    for (std::size_t i = 0; i < n; i++) {
+      m_courses[i] = Course{seeds.at(i)};
+      m_lanes.x[i] = m_config.bird_x;
+      m_lanes.y[i] = m_config.height / 2;
+      m_lanes.velocity[i] = 0;
+      m_lanes.score[i] = 0;
+      m_done[i] = 0;
+    }
+    m_alive = n;
+    m_ticks = 0;
+    m_pipe_x.clear();
+    m_pipe_top.clear();
+    m_pipe_counter = 0;
+    createPipe();
+    movePipes();
+  }
+
+  /// advance every running world by one tick, actions[i] != 0 flaps in world
+  /// i, finished worlds ignore their action
+  void step(const std::uint8_t *actions) {
+    const std::size_t n = size();
+    for (std::size_t i = 0; i < n; i++) {
+      m_lanes.flap[i] = !m_done[i] && actions[i];
+    }
+
+    stepBirds(m_lanes, m_rules, m_closest);
+
+    for (std::size_t i = 0; i < n; i++) {
+      if (m_done[i]) {
+        // parked, keeps the lane far from overflows
+        m_lanes.y[i] = m_config.height / 2;
+        m_lanes.velocity[i] = 0;
+      } else {
+        m_ticks++;
+        if (m_lanes.dead[i] || (m_config.max_score > 0 &&
+                                m_lanes.score[i] >= m_config.max_score)) {
+          m_done[i] = 1;
+          m_final_score[i] = m_lanes.score[i];
+          m_alive--;
+        }
+      }
+    }
+
+    // remove offscreen pipes, they are the oldest ones
+    std::size_t gone = 0;
+    while (gone < m_pipe_x.size() &&
+           m_pipe_x[gone] + m_config.pipe_width < 0) {
+      gone++;
+    }
+    if (gone > 0) {
+      const std::size_t stride = m_pipe_x.size();
+      const std::size_t kept = stride - gone;
+      // rows only move towards the front, forward copies are safe
+      for (std::size_t i = 0; i < n; i++) {
+        auto row = m_pipe_top.begin() + i * stride;
+        std::copy(row + gone, row + stride, m_pipe_top.begin() + i * kept);
+      }
+      m_pipe_top.resize(n * kept);
+      m_pipe_x.erase(m_pipe_x.begin(), m_pipe_x.begin() + gone);
+    }
+
+    // create new pipe periodically
+    m_pipe_counter++;
+    if (m_pipe_counter > m_config.pipe_creation) {
+      m_pipe_counter = 0;
+      createPipe();
+    }
+
+    movePipes();
+  }
+
+  void step(const std::vector<std::uint8_t> &actions) { step(actions.data()); }
+
+  /// size() x ObservationSize values, row i is the observation of world i
+  const double *observations() const { return m_observations.data(); }
+  const double *observation(std::size_t world) const {
+    return m_observations.data() + world * ObservationSize;
+  }
+
+  bool done(std::size_t world) const { return m_done[world]; }
+  bool allDone() const { return m_alive == 0; }
+  std::size_t alive() const { return m_alive; }
+
+  /// ticks survived, same as Bird::score
+  int score(std::size_t world) const {
+    return m_done[world] ? m_final_score[world] : m_lanes.score[world];
+  }
+
+  /// number of bird ticks simulated since reset
+  long ticks() const { return m_ticks; }
+
+private:
+  // pipe x positions are shared by all worlds, only tops are per world:
+  // m_pipe_top holds size() rows of m_pipe_x.size() tops
+  void createPipe() {
+    const std::size_t n = size();
+    const std::size_t stride = m_pipe_x.size();
+    m_pipe_x.push_back(m_config.width);
+
+    m_pipe_top.resize(n * (stride + 1));
+    for (std::size_t i = n; i-- > 0;) {
+      auto begin = m_pipe_top.begin() + i * stride;
+      std::copy_backward(begin, begin + stride,
+                         m_pipe_top.begin() + i * (stride + 1) + stride);
+      m_pipe_top[i * (stride + 1) + stride] =
+          m_courses[i].random(m_config.height - m_config.pipe_gate);
+    }
+  }
+
+  // pipes move at the start of a tick, then the bird observes
+  void movePipes() {
+    for (auto &x : m_pipe_x) {
+      x -= m_config.velocity;
+    }
+
+    // first pipe not yet passed by the birds
+    std::size_t closest = 0;
+    while (closest + 1 < m_pipe_x.size() &&
+           !(m_pipe_x[closest] + m_config.pipe_width > m_config.bird_x)) {
+      closest++;
+    }
+
+    const std::size_t n = size();
+    const std::size_t stride = m_pipe_x.size();
+    const double width = m_config.width;
+    const double height = m_config.height;
+    for (std::size_t i = 0; i < n; i++) {
+      const int x = m_pipe_x[closest];
+      const int top = m_pipe_top[i * stride + closest];
+      m_closest.x[i] = x;
+      m_closest.top[i] = top;
+
+      double *obs = m_observations.data() + i * ObservationSize;
+      obs[0] = m_lanes.y[i] / height;
+      obs[1] = x / width;
+      obs[2] = top / height;
+      obs[3] = (top + m_config.pipe_gate) / height;
+      obs[4] = m_lanes.velocity[i] / 10.0;
+    }
+  }
+
+  Config m_config;
+  std::vector<Course> m_courses;
+  BirdLanes m_lanes;
+  PhysicsRules m_rules;
+  PipeLanes m_closest;
+  std::vector<std::uint8_t> m_done;
+  std::vector<int> m_final_score;
+  std::vector<double> m_observations;
+  std::vector<int> m_pipe_x;
+  std::vector<int> m_pipe_top;
+  int m_pipe_counter{0};
+  std::size_t m_alive{0};
+  long m_ticks{0};
+};
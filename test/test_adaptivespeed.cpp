@@ -0,0 +1,59 @@
+#include <QObject>
+#include <QTest>
+
+#include "p5/adaptivespeed.h"
+
+// feed the same costs for many frames
+void run(AdaptiveSpeed &speed, double tick_ms, double render_ms,
+         int frames = 200) {
+  for (int i = 0; i < frames; i++) {
+    speed.frame(speed.ticks(), tick_ms * speed.ticks(), render_ms);
+  }
+}
+
+class testAdaptiveSpeed : public QObject {
+
+  Q_OBJECT
+
+private slots:
+
+  void fill_the_frame_with_ticks() {
+    AdaptiveSpeed speed(25.0);
+    run(speed, 0.01, 5.0);
+
+    // (25 - 5) / 0.01 ticks
+    QVERIFY(speed.render());
+    QVERIFY(speed.ticks() > 1900 && speed.ticks() <= 2000);
+  }
+
+  void ticks_grow_progressively() {
+    AdaptiveSpeed speed(25.0);
+    int previous = speed.ticks();
+    for (int i = 0; i < 10; i++) {
+      speed.frame(speed.ticks(), 0.001 * speed.ticks(), 1.0);
+      QVERIFY(speed.ticks() <= 2 * previous);
+      previous = speed.ticks();
+    }
+  }
+
+  void slow_ticks_run_at_least_one_tick() {
+    AdaptiveSpeed speed(25.0);
+    run(speed, 100.0, 1.0);
+    QCOMPARE(speed.ticks(), 1);
+  }
+
+  void expensive_render_skips_frames() {
+    AdaptiveSpeed speed(25.0);
+    run(speed, 0.01, 40.0);
+
+    int rendered = 0;
+    for (int i = 0; i < 100; i++) {
+      rendered += speed.render();
+      speed.frame(speed.ticks(), 0.01 * speed.ticks(), 40.0);
+    }
+    // render cost is limited to half the budget: one frame out of 4
+    QCOMPARE(rendered, 25);
+  }
+};
+QTEST_MAIN(testAdaptiveSpeed)
+#include "test_adaptivespeed.moc"
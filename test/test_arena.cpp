@@ -0,0 +1,74 @@
+#include "neuralnetwork/nn.h"
+#include <QObject>
+#include <QTest>
+
+// every heap allocation of the test is counted
+#include "allocations.h"
+
+class testArena : public QObject {
+
+  Q_OBJECT
+
+private slots:
+
+  void scopes_rewind_the_arena() {
+    BumpArena arena(1024);
+    void *first = arena.allocate(100, 8);
+    {
+      BumpArena::Scope scope(arena);
+      void *p = arena.allocate(3, 1);
+      void *q = arena.allocate(16, 16);
+      QVERIFY(reinterpret_cast<std::uintptr_t>(q) % 16 == 0);
+      QVERIFY(q > p);
+      {
+        BumpArena::Scope inner(arena);
+        arena.allocate(2000, 8); // larger than a chunk
+      }
+      QCOMPARE(arena.chunkCount(), std::size_t(2));
+    }
+    QCOMPARE(arena.used(), std::size_t(100));
+
+    // memory is reused after a rewind
+    arena.reset();
+    QCOMPARE(arena.allocate(100, 8), first);
+    QCOMPARE(arena.chunkCount(), std::size_t(2));
+  }
+
+  void matrix_storage_from_arena() {
+    BumpArena arena;
+    {
+      BumpArena::Scope scope(arena);
+      Matrix m(3, 4, &arena);
+      QCOMPARE(m.resource(), static_cast<std::pmr::memory_resource *>(&arena));
+      QVERIFY(arena.used() >= 12 * sizeof(double));
+
+      // copies do not keep the arena
+      Matrix copy = m;
+      QVERIFY(copy.resource() != m.resource());
+      QVERIFY(copy == m);
+    }
+    QCOMPARE(arena.used(), std::size_t(0));
+  }
+
+  void train_does_not_allocate_once_warm() {
+    NeuralNetwork nn(5, 8, 2);
+    std::vector<double> input{0.1, 0.2, 0.3, 0.4, 0.5};
+    std::vector<double> target{1.0, 0.0};
+    std::vector<double> output;
+
+    // warm up the thread arena and the output buffer
+    nn.train(input, target);
+    nn.predict(input, output);
+
+    const long before = allocations;
+    for (int i = 0; i < 1000; i++) {
+      nn.train(input, target);
+      nn.predict(input, output);
+    }
+    QCOMPARE(allocations - before, 0L);
+    QCOMPARE(BumpArena::local().used(), std::size_t(0));
+  }
+};
+
+QTEST_MAIN(testArena)
+#include "test_arena.moc"
@@ -0,0 +1,81 @@
+#include "neuralnetwork/brain.h"
+#include <QObject>
+#include <QTest>
+
+class testBrain : public QObject {
+
+  Q_OBJECT
+
+private slots:
+
+  void test_predict_matches_network() {
+    BrainArena arena(Topology{5, 8, 2});
+    NeuralNetwork network(5, 8, 2);
+    Brain brain(arena, network);
+
+    std::mt19937 gen(3);
+    std::uniform_real_distribution<> input(-1.0, 1.0);
+    for (int i = 0; i < 100; i++) {
+      std::vector<double> in(5);
+      for (auto &v : in) {
+        v = input(gen);
+      }
+      QCOMPARE(brain.predict(in), network.predict(in));
+    }
+
+    QVERIFY(brain.toNetwork() == network);
+  }
+
+  void test_copy_on_write() {
+    BrainArena arena(Topology{5, 8, 2});
+    Brain parent(arena);
+    Brain child = parent;
+    QCOMPARE(arena.size(), std::size_t(1));
+    QCOMPARE(child.parameters(), parent.parameters());
+
+    auto before = parent.toNetwork();
+    child.mutate(1.0);
+    QCOMPARE(arena.size(), std::size_t(2));
+    QVERIFY(child.parameters() != parent.parameters());
+    QVERIFY(parent.toNetwork() == before);
+    QVERIFY(!(child.toNetwork() == before));
+
+    // a mutated brain with no other reference keeps its slot
+    const double *slot = child.parameters();
+    child.mutate(1.0);
+    QCOMPARE(child.parameters(), slot);
+  }
+
+  void test_slots_are_reused() {
+    BrainArena arena(Topology{5, 8, 2});
+    {
+      std::vector<Brain> population;
+      for (int i = 0; i < 300; i++) {
+        population.emplace_back(arena);
+      }
+      QCOMPARE(arena.size(), std::size_t(300));
+    }
+    QCOMPARE(arena.size(), std::size_t(0));
+
+    std::vector<Brain> next;
+    for (int i = 0; i < 300; i++) {
+      next.emplace_back(arena);
+    }
+    QCOMPARE(arena.capacity(), std::size_t(300));
+
+    Brain moved = std::move(next.back());
+    QVERIFY(next.back().empty());
+    next.pop_back();
+    QCOMPARE(arena.size(), std::size_t(300));
+  }
+
+  void test_topology_mismatch() {
+    BrainArena arena(Topology{5, 8, 2});
+    QVERIFY_EXCEPTION_THROWN(Brain(arena, NeuralNetwork(4, 8, 2)),
+                             std::runtime_error);
+    QCOMPARE(arena.size(), std::size_t(0));
+  }
+};
+
+QTEST_MAIN(testBrain)
+#include "test_brain.moc"
@@ -0,0 +1,84 @@
+#include <QObject>
+#include <QTest>
+
+#include "p5/displaylist.h"
+#include "p5/offscreencanvas.h"
+#include "p5/threadpool.h"
+
+// a scene drawn through the Canvas interface, without text so that images
+// do not depend on fonts
+void drawScene(Canvas &canvas, int frame) {
+  canvas.background(255, 255, 255);
+  canvas.stroke(80, 80, 80);
+  canvas.fill(200, 0, 0);
+  canvas.rect(10 + frame, 10, 30, 20);
+  canvas.noFill();
+  canvas.line(0, 0, canvas.width(), canvas.height());
+  canvas.noStroke();
+  canvas.fill(0, 0, 255);
+  canvas.rects({{50, 50, 5, 5}, {60, 50, 5, 5}, {70, 50, 5, 5 + frame}});
+}
+
+class testDisplayList : public QObject {
+
+  Q_OBJECT
+
+private slots:
+
+  void records_and_replays() {
+    RecordingCanvas canvas(100, 80);
+    drawScene(canvas, 0);
+    canvas.text("12", 5, 6);
+    const DisplayList list = canvas.take();
+    QCOMPARE(list.size(), std::size_t{10});
+    QVERIFY(canvas.list().empty());
+
+    // replaying into a recorder gives the same commands
+    RecordingCanvas copy(100, 80);
+    list.replay(copy);
+    QVERIFY(copy.list() == list);
+    QCOMPARE(copy.list().hash(), list.hash());
+
+    RecordingCanvas other(100, 80);
+    drawScene(other, 1);
+    other.text("12", 5, 6);
+    QVERIFY(other.list() != list);
+    QVERIFY(other.list().hash() != list.hash());
+  }
+
+  void replay_draws_like_the_canvas() {
+    OffscreenCanvas direct(100, 80);
+    direct.beginFrame(true);
+    drawScene(direct, 3);
+    direct.endFrame();
+
+    RecordingCanvas recorder(100, 80);
+    drawScene(recorder, 3);
+    OffscreenCanvas replayed(100, 80);
+    replayed.beginFrame(true);
+    recorder.list().replay(replayed);
+    replayed.endFrame();
+
+    QVERIFY(direct.image() == replayed.image());
+  }
+
+  void scenes_are_built_on_any_thread() {
+    ThreadPool pool(3);
+    std::vector<DisplayList> lists(12);
+    pool.parallelFor(lists.size(),
+                     [&lists](std::size_t begin, std::size_t end) {
+                       for (std::size_t frame = begin; frame < end; frame++) {
+                         RecordingCanvas canvas(100, 80);
+                         drawScene(canvas, static_cast<int>(frame));
+                         lists[frame] = canvas.take();
+                       }
+                     });
+    for (std::size_t frame = 0; frame < lists.size(); frame++) {
+      RecordingCanvas canvas(100, 80);
+      drawScene(canvas, static_cast<int>(frame));
+      QVERIFY(canvas.list() == lists[frame]);
+    }
+  }
+};
+QTEST_MAIN(testDisplayList)
+#include "test_displaylist.moc"
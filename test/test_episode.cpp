@@ -0,0 +1,124 @@
+#include <QObject>
+#include <QTemporaryDir>
+#include <QTest>
+
+#include "episode.h"
+
+#include <fstream>
+#include <iterator>
+#include <random>
+#include <string>
+
+std::vector<bool> decode(const FlapStream &stream) {
+  std::vector<bool> decisions;
+  FlapStream::Reader reader(stream);
+  for (std::uint32_t i = 0; i < stream.size(); i++) {
+    decisions.push_back(reader.next());
+  }
+  return decisions;
+}
+
+class testEpisode : public QObject {
+
+  Q_OBJECT
+
+private slots:
+
+  void empty_stream_reads_no_flap() {
+    FlapStream stream;
+    FlapStream::Reader reader(stream);
+    QVERIFY(stream.bytes().empty());
+    QVERIFY(reader.next() == false);
+  }
+
+  void stream_starting_with_flap() {
+    FlapStream stream;
+    std::vector<bool> decisions{true, true, false, true};
+    for (bool flap : decisions) {
+      stream.push(flap);
+    }
+    QVERIFY(decode(stream) == decisions);
+  }
+
+  void random_stream_round_trip() {
+    std::mt19937 gen(42);
+    std::bernoulli_distribution flap(0.3);
+
+    FlapStream stream;
+    std::vector<bool> decisions;
+    for (int i = 0; i < 10000; i++) {
+      decisions.push_back(flap(gen));
+      stream.push(decisions.back());
+    }
+    QCOMPARE(stream.size(), 10000u);
+    QVERIFY(decode(stream) == decisions);
+  }
+
+  void long_runs_are_compact() {
+    FlapStream stream;
+    for (int i = 0; i < 100000; i++) {
+      stream.push(i % 1000 == 0);
+    }
+    // 200 runs, less than 1000 need 2 bytes each
+    QVERIFY(stream.bytes().size() <= 400);
+  }
+
+  void episode_save_and_load() {
+    Episode e{1234, 640, 480};
+    int a = e.addBird(20, 240, 0);
+    int b = e.addBird(30, 240, 17);
+    for (int i = 0; i < 500; i++) {
+      e.record(a, i % 7 == 0);
+      e.record(b, i % 3 == 0);
+    }
+
+    QTemporaryDir dir;
+    auto path = dir.filePath("episode.bin").toStdString();
+    e.save(path);
+    auto loaded = Episode::Load(path);
+
+    QCOMPARE(loaded.seed, 1234u);
+    QCOMPARE(loaded.width, 640);
+    QCOMPARE(loaded.height, 480);
+    QCOMPARE(loaded.flaps.size(), std::size_t{2});
+    QCOMPARE(loaded.starts[b].x, 30);
+    QCOMPARE(loaded.starts[b].tick, 17u);
+    QVERIFY(decode(loaded.flaps[a]) == decode(e.flaps[a]));
+    QVERIFY(decode(loaded.flaps[b]) == decode(e.flaps[b]));
+  }
+
+  void load_rejects_other_files() {
+    QTemporaryDir dir;
+    auto path = dir.filePath("not_an_episode.bin").toStdString();
+    std::ofstream(path) << "hello world";
+    QVERIFY_EXCEPTION_THROWN(Episode::Load(path), std::runtime_error);
+  }
+
+  void load_rejects_truncated_files() {
+    Episode e{1234, 640, 480};
+    int a = e.addBird(20, 240, 0);
+    for (int i = 0; i < 500; i++) {
+      e.record(a, i % 7 == 0);
+    }
+
+    QTemporaryDir dir;
+    auto path = dir.filePath("episode.bin").toStdString();
+    e.save(path);
+    std::string data;
+    {
+      std::ifstream f(path, std::ios::binary);
+      data.assign(std::istreambuf_iterator<char>(f), {});
+    }
+
+    // the last bytes of the flaps are missing
+    std::ofstream(path, std::ios::binary) << data.substr(0, data.size() - 1);
+    QVERIFY_EXCEPTION_THROWN(Episode::Load(path), std::runtime_error);
+
+    // a byte count far past the end of the file, read before the flaps
+    data[data.size() - e.flaps[a].bytes().size() - 1] = char(0xff);
+    std::ofstream(path, std::ios::binary) << data;
+    QVERIFY_EXCEPTION_THROWN(Episode::Load(path), std::runtime_error);
+  }
+};
+QTEST_MAIN(testEpisode)
+#include "test_episode.moc"
@@ -0,0 +1,79 @@
+#include "rollout.h"
+#include <QObject>
+#include <QTest>
+
+class testEpisodeCache : public QObject {
+
+  Q_OBJECT
+
+private slots:
+
+  void test_hash() {
+    NeuralNetwork a(5, 8, 2);
+    NeuralNetwork b = a;
+    QCOMPARE(a.hash(), b.hash());
+
+    auto params = b.parameters();
+    params[3] += 1e-12;
+    b.setParameters(params);
+    QVERIFY(a.hash() != b.hash());
+
+    // same parameters, other topology
+    NeuralNetwork c(3, 6, 6);
+    c.setParameters(std::vector<double>(c.parameterCount(), 0.5));
+    NeuralNetwork d(5, 8, 2);
+    d.setParameters(std::vector<double>(d.parameterCount(), 0.5));
+    QCOMPARE(c.parameterCount(), d.parameterCount());
+    QVERIFY(c.hash() != d.hash());
+  }
+
+  void test_lru() {
+    EpisodeCache cache(2);
+    cache.insert({1, 7}, {10, 10});
+    cache.insert({2, 7}, {20, 20});
+    QVERIFY(cache.find({1, 7})); // 1 is now the most recent
+    cache.insert({3, 7}, {30, 30});
+
+    QCOMPARE(cache.size(), std::size_t(2));
+    QVERIFY(!cache.find({2, 7}));
+    QVERIFY(!cache.find({1, 8}));
+    QCOMPARE(cache.find({1, 7})->score, 10.0);
+    QCOMPARE(cache.find({3, 7})->death_tick, 30l);
+
+    QCOMPARE(cache.stats().hits, 3l);
+    QCOMPARE(cache.stats().misses, 2l);
+    cache.resetStats();
+    QCOMPARE(cache.stats().hitRate(), 0.0);
+  }
+
+  void test_cached_rollout() {
+    VectorEnv::Config config;
+    config.max_score = 300;
+    const std::vector<std::uint32_t> seeds{3, 4};
+    ThreadPool pool(2);
+
+    std::vector<NeuralNetwork> brains;
+    for (int i = 0; i < 6; i++) {
+      brains.emplace_back(5, 8, 2);
+    }
+    brains.push_back(brains[0]); // duplicate played once
+    auto expected = rollout(brains, seeds, config, pool);
+
+    EpisodeCache cache(100);
+    auto first = cachedRollout(brains, seeds, config, pool, cache);
+    QCOMPARE(first.scores, expected.scores);
+    QVERIFY(first.ticks < expected.ticks);
+    QCOMPARE(cache.size(), std::size_t(12));
+    QCOMPARE(cache.stats().hits, 0l);
+
+    cache.resetStats();
+    auto second = cachedRollout(brains, seeds, config, pool, cache);
+    QCOMPARE(second.scores, expected.scores);
+    QCOMPARE(second.ticks, 0l);
+    QCOMPARE(cache.stats().hits, 14l);
+    QCOMPARE(cache.stats().misses, 0l);
+  }
+};
+
+QTEST_MAIN(testEpisodeCache)
+#include "test_episodecache.moc"
@@ -0,0 +1,84 @@
+#include "neuralnetwork/es.h"
+#include "p5/threadpool.h"
+#include <QObject>
+#include <QTest>
+#include <atomic>
+
+class testES : public QObject {
+
+  Q_OBJECT
+
+private slots:
+
+  void test_centered_ranks() {
+    auto ranks = EvolutionStrategy::centeredRanks({3.0, -1.0, 10.0, 3.0, 0.0});
+    std::vector<double> expected{0.125, -0.5, 0.5, 0.125, -0.25};
+    QCOMPARE(ranks, expected);
+  }
+
+  void test_antithetic() {
+    EvolutionStrategy es({1.0, 2.0, 3.0}, 42);
+    auto candidates = es.ask();
+    QCOMPARE(candidates.size(), es.populationSize());
+    for (std::size_t p = 0; p < candidates.size(); p += 2) {
+      for (std::size_t k = 0; k < 3; k++) {
+        QCOMPARE(candidates[p][k] + candidates[p + 1][k],
+                 2 * es.mean()[k]);
+      }
+    }
+    QVERIFY_EXCEPTION_THROWN(es.tell({1.0}), std::runtime_error);
+  }
+
+  void test_maximize_quadratic() {
+    // f(x) = -|x - target|^2
+    const std::vector<double> target{0.5, -1.0, 2.0, 0.0};
+    EvolutionStrategy es(std::vector<double>(target.size(), 0.0), 1);
+    ThreadPool pool(4);
+
+    for (int generation = 0; generation < 300; generation++) {
+      auto candidates = es.ask();
+      std::vector<double> fitnesses(candidates.size());
+      pool.parallelFor(candidates.size(), [&](std::size_t begin,
+                                              std::size_t end) {
+        for (std::size_t i = begin; i < end; i++) {
+          double f = 0;
+          for (std::size_t k = 0; k < target.size(); k++) {
+            f -= (candidates[i][k] - target[k]) * (candidates[i][k] - target[k]);
+          }
+          fitnesses[i] = f;
+        }
+      });
+      es.tell(fitnesses);
+    }
+
+    for (std::size_t k = 0; k < target.size(); k++) {
+      QVERIFY(std::abs(es.mean()[k] - target[k]) < 0.1);
+    }
+  }
+
+  void test_thread_pool() {
+    ThreadPool pool(3);
+    std::vector<int> visited(1000, 0);
+    std::atomic<int> chunks{0};
+    pool.parallelFor(visited.size(), [&](std::size_t begin, std::size_t end) {
+      chunks++;
+      for (std::size_t i = begin; i < end; i++) {
+        visited[i]++;
+      }
+    }, 7);
+    QCOMPARE(chunks.load(), 7);
+    QVERIFY(std::all_of(visited.begin(), visited.end(),
+                        [](int v) { return v == 1; }));
+
+    QVERIFY_EXCEPTION_THROWN(
+        pool.parallelFor(10,
+                         [](std::size_t begin, std::size_t) {
+                           if (begin == 0)
+                             throw std::runtime_error("chunk failed");
+                         }),
+        std::runtime_error);
+  }
+};
+
+QTEST_MAIN(testES)
+#include "test_es.moc"
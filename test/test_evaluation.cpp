@@ -0,0 +1,58 @@
+#include "evaluation.h"
+#include <QObject>
+#include <QTest>
+
+class testEvaluation : public QObject {
+
+  Q_OBJECT
+
+private slots:
+
+  void test_transport() {
+    auto ends = SocketTransport::pair();
+    evaluation::Message message;
+    message.type = evaluation::Message::Evaluate;
+    message.begin = 3;
+    message.end = 7;
+    ends.first.send(message);
+
+    evaluation::Message received;
+    QVERIFY(ends.second.receive(received));
+    QCOMPARE(received.type, std::uint32_t(evaluation::Message::Evaluate));
+    QCOMPARE(received.begin, std::uint64_t(3));
+    QCOMPARE(received.end, std::uint64_t(7));
+
+    ends.first.close();
+    QVERIFY(!ends.second.receive(received));
+  }
+
+  void test_workers_match_rollout() {
+    VectorEnv::Config config;
+    config.max_score = 300;
+    const std::vector<std::uint32_t> seeds{1, 2};
+
+    EvaluationWorkers workers(3);
+    QCOMPARE(workers.size(), std::size_t(3));
+    ThreadPool pool(2);
+
+    // the population grows then shrinks, the segment follows
+    for (std::size_t count : {10, 40, 5}) {
+      std::vector<NeuralNetwork> brains;
+      for (std::size_t i = 0; i < count; i++) {
+        brains.emplace_back(5, 8, 2);
+      }
+      auto expected = rollout(brains, seeds, config, pool);
+      auto result = workers.evaluate(brains, seeds, config);
+      QCOMPARE(result.scores, expected.scores);
+      QCOMPARE(result.ticks, expected.ticks);
+    }
+
+    std::vector<NeuralNetwork> mixed{NeuralNetwork{5, 8, 2},
+                                     NeuralNetwork{5, 4, 2}};
+    QVERIFY_EXCEPTION_THROWN(workers.evaluate(mixed, seeds, config),
+                             std::runtime_error);
+  }
+};
+
+QTEST_MAIN(testEvaluation)
+#include "test_evaluation.moc"
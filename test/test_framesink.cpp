@@ -0,0 +1,112 @@
+#include <QObject>
+#include <QTemporaryDir>
+#include <QTest>
+
+#include "p5/framesink.h"
+#include "p5/offscreencanvas.h"
+
+#include <fstream>
+#include <iterator>
+#include <vector>
+
+std::string readAll(const std::string &path) {
+  std::ifstream f(path, std::ios::binary);
+  return {std::istreambuf_iterator<char>(f), std::istreambuf_iterator<char>()};
+}
+
+class testFrameSink : public QObject {
+
+  Q_OBJECT
+
+private slots:
+
+  void format_is_chosen_from_extension() {
+    QVERIFY(FrameSink::formatFor("run.ppm") == FrameSink::Format::PPM);
+    QVERIFY(FrameSink::formatFor("run.y4m") == FrameSink::Format::Y4M);
+    QVERIFY(FrameSink::formatFor("|ffmpeg -i - run.mp4") ==
+            FrameSink::Format::Y4M);
+  }
+
+  void write_ppm_frames() {
+    QTemporaryDir dir;
+    auto path = dir.filePath("frames.ppm").toStdString();
+
+    QImage frame(3, 2, QImage::Format_RGB32);
+    frame.fill(QColor{10, 20, 30});
+    {
+      FrameSink sink(path, 3, 2, 30);
+      sink.write(frame);
+      sink.write(frame);
+      QCOMPARE(sink.frameCount(), 2);
+    }
+
+    std::string header = "P6\n3 2\n255\n";
+    std::string pixels;
+    for (int i = 0; i < 6; i++) {
+      pixels += "\x0a\x14\x1e";
+    }
+    QVERIFY(readAll(path) == header + pixels + header + pixels);
+  }
+
+  void write_y4m_frames() {
+    QTemporaryDir dir;
+    auto path = dir.filePath("frames.y4m").toStdString();
+
+    QImage frame(5, 3, QImage::Format_RGB32);
+    frame.fill(QColor{255, 255, 255});
+    {
+      FrameRecorder recorder(std::make_unique<FrameSink>(path, 5, 3, 25));
+      recorder.push(frame.copy());
+      recorder.push(frame.copy());
+    }
+
+    std::string header = "YUV4MPEG2 W5 H3 F25:1 Ip A1:1 C420jpeg\n";
+    // luma 5x3, chroma planes 3x2
+    std::string frame_data = "FRAME\n" + std::string(15, '\xff') +
+                             std::string(12, '\x80');
+    QVERIFY(readAll(path) == header + frame_data + frame_data);
+  }
+
+  void frame_size_must_not_change() {
+    QTemporaryDir dir;
+    FrameSink sink(dir.filePath("frames.y4m").toStdString(), 4, 4, 30);
+
+    QImage frame(2, 2, QImage::Format_RGB32);
+    QVERIFY_EXCEPTION_THROWN(sink.write(frame), std::runtime_error);
+  }
+
+  void offscreen_options_are_checked() {
+    auto parse = [](std::vector<const char *> args) {
+      args.insert(args.begin(), "flappy_bird");
+      return OffscreenOptions::parse(static_cast<int>(args.size()),
+                                     const_cast<char **>(args.data()));
+    };
+
+    QVERIFY(!parse({}));
+    auto options = parse({"--size", "320x200", "--record", "run.y4m"});
+    QVERIFY(options);
+    QCOMPARE(options->output, std::string("run.y4m"));
+    QCOMPARE(options->width, 320);
+
+    QVERIFY_EXCEPTION_THROWN(parse({"--record"}), std::runtime_error);
+    QVERIFY_EXCEPTION_THROWN(parse({"--record", "run.y4m", "--every"}),
+                             std::runtime_error);
+    QVERIFY_EXCEPTION_THROWN(parse({"--record", "run.y4m", "--size", "-4x3"}),
+                             std::runtime_error);
+    QVERIFY_EXCEPTION_THROWN(parse({"--record", "run.y4m", "--size", "4x0"}),
+                             std::runtime_error);
+    QVERIFY_EXCEPTION_THROWN(parse({"--record", "run.y4m", "--every", "abc"}),
+                             std::runtime_error);
+    QVERIFY_EXCEPTION_THROWN(parse({"--record", "run.y4m", "--every", "0"}),
+                             std::runtime_error);
+    QVERIFY_EXCEPTION_THROWN(parse({"--record", "run.y4m", "--ticks", "-5"}),
+                             std::runtime_error);
+    QVERIFY_EXCEPTION_THROWN(parse({"--record", "run.y4m", "--ticks", "9x"}),
+                             std::runtime_error);
+    options = parse({"--record", "run.y4m", "--every", "3", "--ticks", "0"});
+    QCOMPARE(options->every, 3);
+    QCOMPARE(options->ticks, 0L);
+  }
+};
+QTEST_MAIN(testFrameSink)
+#include "test_framesink.moc"
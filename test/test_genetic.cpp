@@ -0,0 +1,57 @@
+#include <QObject>
+#include <QTest>
+
+#include "genetic.h"
+
+#include <list>
+#include <map>
+
+struct Individual {
+  double score{0};
+  double fitness{0};
+};
+
+class testGenetic : public QObject {
+
+  Q_OBJECT
+
+private slots:
+
+  void picks_follow_the_fitness() {
+    std::list<Individual> population{{0, 0}, {1, 0}, {3, 0}};
+    genetic::calculateFitness(population);
+    QCOMPARE(population.back().fitness, 0.75);
+
+    std::mt19937 gen(1);
+    genetic::Selection<std::list<Individual>> selection(population);
+    std::map<double, int> picks; // by score
+    for (int i = 0; i < 4000; i++) {
+      picks[selection.pick(gen).score]++;
+    }
+    QCOMPARE(picks[0], 0);
+    QVERIFY(std::abs(picks[1] - 1000) < 120);
+    QVERIFY(std::abs(picks[3] - 3000) < 120);
+  }
+
+  void zero_scores_pick_uniformly() {
+    std::list<Individual> population(4);
+    genetic::calculateFitness(population);
+    for (const auto &individual : population) {
+      QCOMPARE(individual.fitness, 0.25);
+    }
+
+    // no positive fitness, every individual can still be picked
+    std::mt19937 gen(2);
+    std::map<const Individual *, int> picks;
+    for (auto &individual : population) {
+      individual.fitness = 0;
+    }
+    genetic::Selection<std::list<Individual>> selection(population);
+    for (int i = 0; i < 400; i++) {
+      picks[&selection.pick(gen)]++;
+    }
+    QCOMPARE(picks.size(), std::size_t{4});
+  }
+};
+QTEST_MAIN(testGenetic)
+#include "test_genetic.moc"
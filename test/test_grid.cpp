@@ -3,15 +3,42 @@
 
 #include "p5/grid.h"
 
+#include <atomic>
+#include <set>
+
 struct MinimalCell {
   Position position;
   explicit MinimalCell(Position position_p) : position(position_p) {}
 };
 
+struct FloodCell {
+  Position position;
+  bool wall{false};
+  int visits{0};
+  explicit FloodCell(Position position_p) : position(position_p) {}
+};
+
 class testGrid : public QObject {
 
   Q_OBJECT
 
+  template <typename S, typename G>
+  void sameNeighbors(G &grid, ThreadPool *pool) {
+    std::atomic<int> mismatches{0};
+    grid.template forEachWithNeighbors<S>(
+        [&grid, &mismatches](FloodCell &cell, auto &&neighbors) {
+          std::multiset<Position> walked;
+          std::multiset<Position> looked_up;
+          neighbors([&walked](FloodCell &n) { walked.insert(n.position); });
+          grid.template forEachNeighbor<S>(cell, [&looked_up](FloodCell &n) {
+            looked_up.insert(n.position);
+          });
+          mismatches += walked != looked_up;
+        },
+        pool);
+    QCOMPARE(mismatches.load(), 0);
+  }
+
 private slots:
 
   void can_iterate_all_grid_data() {
@@ -45,6 +72,215 @@ private slots:
       }
     }
   }
+
+  void neighbors_are_visited_once() {
+    Grid<MinimalCell> g(Size{6, 5});
+
+    auto neighbors = [&g](Position pos) {
+      std::multiset<Position> visited;
+      g.forEachNeighbor(g.at(pos), [&visited](MinimalCell &neighbor) {
+        visited.insert(neighbor.position);
+      });
+      return visited;
+    };
+
+    QCOMPARE(neighbors({0, 0}),
+             (std::multiset<Position>{{0, 1}, {1, 0}, {1, 1}}));
+    QCOMPARE(neighbors({2, 0}).size(), std::size_t{5});
+    QCOMPARE(neighbors({4, 5}).size(), std::size_t{3});
+
+    auto interior = neighbors({2, 3});
+    QCOMPARE(interior.size(), std::size_t{8});
+    QCOMPARE(std::set<Position>(interior.begin(), interior.end()).size(),
+             std::size_t{8});
+    QVERIFY(interior.count({2, 3}) == 0);
+  }
+
+  void stencils() {
+    QCOMPARE(FourNeighbors::offsets.size(), std::size_t{4});
+    QCOMPARE(EightNeighbors::offsets.size(), std::size_t{8});
+    QCOMPARE((Stencil<2, true>::offsets.size()), std::size_t{24});
+    QCOMPARE((Stencil<2, false>::offsets.size()), std::size_t{12});
+
+    Grid<MinimalCell> g(Size{7, 7});
+    int count = 0;
+    g.forEachNeighbor<FourNeighbors>(g.at({3, 3}), [&count](MinimalCell &n) {
+      QVERIFY(std::abs(n.position.column - 3) + std::abs(n.position.row - 3) ==
+              1);
+      count++;
+    });
+    QCOMPARE(count, 4);
+
+    count = 0;
+    g.forEachNeighbor<Stencil<2, true>>(g.at({1, 3}),
+                                        [&count](MinimalCell &) { count++; });
+    QCOMPARE(count, 4 * 5 - 1);
+  }
+
+  void flood_fill_stops_at_walls() {
+    // a wall on column 3, the fill stays left of it
+    Grid<FloodCell> g(Size{5, 8});
+    for (int row = 0; row < 5; row++) {
+      g.at({3, row}).wall = true;
+    }
+
+    auto count = g.floodFill<FourNeighbors>(
+        {1, 1}, [](const FloodCell &cell) { return !cell.wall; },
+        [](FloodCell &cell) {
+          cell.visits++;
+          return true;
+        });
+    QCOMPARE(count, std::size_t{15});
+
+    g.forEach([](const FloodCell &cell) {
+      QCOMPARE(cell.visits, cell.position.column < 3 ? 1 : 0);
+    });
+
+    QCOMPARE(g.floodFill(
+                 {3, 0}, [](const FloodCell &cell) { return !cell.wall; },
+                 [](FloodCell &) { return true; }),
+             std::size_t{0});
+  }
+
+  void flood_fill_large_empty_board() {
+    // deep enough to overflow the stack of a recursive fill
+    Grid<FloodCell> g(Size{2000, 2000});
+    std::size_t revealed = g.floodFill(
+        {1000, 1000}, [](const FloodCell &cell) { return cell.visits == 0; },
+        [](FloodCell &cell) {
+          cell.visits++;
+          return true;
+        });
+    QCOMPARE(revealed, std::size_t{2000 * 2000});
+
+    int twice = 0;
+    g.forEach([&twice](const FloodCell &cell) { twice += cell.visits != 1; });
+    QCOMPARE(twice, 0);
+  }
+
+  void tiled_layout() {
+    // partial tiles on the right and bottom borders
+    const Size size{37, 45};
+    Grid<FloodCell, Tiled<16>> tiled(size);
+    Grid<FloodCell> plain(size);
+
+    std::set<Position> seen;
+    tiled.forEach([&seen](const FloodCell &cell) {
+      QVERIFY(seen.insert(cell.position).second);
+    });
+    QCOMPARE(seen.size(), std::size_t{37 * 45});
+
+    for (int column = 0; column < size.column; column++) {
+      for (int row = 0; row < size.row; row++) {
+        QVERIFY(tiled.at({column, row}).position == Position({column, row}));
+      }
+    }
+    QVERIFY_EXCEPTION_THROWN(tiled.at({45, 0}), std::out_of_range);
+    QVERIFY_EXCEPTION_THROWN(plain.at({0, -1}), std::out_of_range);
+
+    for (Position pos : {Position{0, 0}, Position{15, 16}, Position{44, 36},
+                         Position{20, 30}}) {
+      std::set<Position> a;
+      std::set<Position> b;
+      tiled.forEachNeighbor(tiled.at(pos), [&a](FloodCell &n) {
+        a.insert(n.position);
+      });
+      plain.forEachNeighbor(plain.at(pos), [&b](FloodCell &n) {
+        b.insert(n.position);
+      });
+      QVERIFY(a == b);
+    }
+
+    tiled.at({10, 0}).wall = true;
+    tiled.at({10, 1}).wall = true;
+    auto filled = tiled.floodFill<FourNeighbors>(
+        {0, 0}, [](const FloodCell &cell) { return !cell.wall; },
+        [](FloodCell &cell) {
+          cell.visits++;
+          return true;
+        });
+    QCOMPARE(filled, std::size_t{37 * 45 - 2});
+  }
+
+  void tiles_cover_the_grid() {
+    ThreadPool pool(3);
+    const Size size{70, 130};
+    Grid<FloodCell, Tiled<32>> tiled(size);
+    Grid<FloodCell> plain(size);
+
+    // checked after the parallel loop, on the test thread
+    std::atomic<int> tiles{0};
+    std::atomic<int> outside{0};
+    tiled.forEachTile(
+        [&](const Tile &tile, FloodCell *cells, std::size_t count) {
+          tiles++;
+          for (std::size_t i = 0; i < count; i++) {
+            const Position pos = cells[i].position;
+            outside += pos.column < tile.origin.column ||
+                       pos.column >= tile.origin.column + tile.size.column ||
+                       pos.row < tile.origin.row ||
+                       pos.row >= tile.origin.row + tile.size.row;
+            cells[i].visits++;
+          }
+        },
+        &pool);
+    QCOMPARE(tiles.load(), 5 * 3);
+    QCOMPARE(outside.load(), 0);
+
+    plain.forEach([](FloodCell &cell) { cell.visits++; }, pool);
+    tiled.forEach([](FloodCell &cell) { cell.visits++; }, pool);
+    plain.forEach([](const FloodCell &cell) { QCOMPARE(cell.visits, 1); });
+    tiled.forEach([](const FloodCell &cell) { QCOMPARE(cell.visits, 2); });
+  }
+
+  void tile_walk_finds_the_same_neighbors() {
+    // partial tiles on the right and bottom borders
+    const Size size{37, 45};
+    ThreadPool pool(3);
+    Grid<FloodCell> plain(size);
+    Grid<FloodCell, Tiled<8>> tiled(size);
+    Grid<FloodCell, Tiled<1>> single(size);
+    sameNeighbors<EightNeighbors>(plain, nullptr);
+    sameNeighbors<EightNeighbors>(tiled, &pool);
+    sameNeighbors<FourNeighbors>(tiled, nullptr);
+    sameNeighbors<Stencil<2, true>>(plain, &pool);
+    sameNeighbors<Stencil<2, true>>(tiled, nullptr);
+    // neighbors further than the tiles around
+    sameNeighbors<Stencil<2, true>>(single, nullptr);
+    // a last tile narrower than the stencil
+    Grid<FloodCell, Tiled<8>> thin(Size{33, 41});
+    sameNeighbors<Stencil<2, true>>(thin, &pool);
+  }
+
+  void dirty_cells_are_tracked_once() {
+    Grid<FloodCell, Tiled<8>> grid(Size{20, 30});
+    QVERIFY(!grid.dirty());
+
+    // a flood over an empty grid marks every cell once
+    grid.floodFill(
+        {3, 4}, [](const FloodCell &cell) { return cell.visits == 0; },
+        [&grid](FloodCell &cell) {
+          cell.visits++;
+          grid.setDirty(cell);
+          return true;
+        });
+    grid.setDirty(grid.at({3, 4}));
+    QCOMPARE(grid.dirtyCount(), std::size_t{600});
+
+    grid.clearDirty();
+    QVERIFY(!grid.dirty());
+    grid.setDirty(grid.at({7, 2}));
+    grid.setDirty(grid.at({0, 0}));
+    grid.setDirty(grid.at({7, 2}));
+    std::vector<Position> dirty;
+    grid.forEachDirty(
+        [&dirty](const FloodCell &cell) { dirty.push_back(cell.position); });
+    QVERIFY((dirty == std::vector<Position>{{7, 2}, {0, 0}}));
+
+    grid.clearDirty();
+    grid.setAllDirty();
+    QCOMPARE(grid.dirtyCount(), std::size_t{600});
+  }
 };
 QTEST_MAIN(testGrid)
 #include "test_grid.moc"
@@ -0,0 +1,102 @@
+#include "halloffame.h"
+#include <QObject>
+#include <QTemporaryDir>
+#include <QTest>
+
+#include <fstream>
+
+class testHallOfFame : public QObject {
+
+  Q_OBJECT
+
+private slots:
+
+  void test_add_and_reopen() {
+    QTemporaryDir dir;
+    auto path = dir.filePath("hall_of_fame.bin").toStdString();
+    std::remove(path.c_str());
+
+    BrainArena arena(Topology{5, 8, 2});
+    std::vector<Brain> brains;
+    for (int i = 0; i < 5; i++) {
+      brains.emplace_back(arena);
+    }
+
+    {
+      HallOfFame hall(path, arena.topology());
+      QCOMPARE(hall.size(), std::size_t{0});
+      QCOMPARE(hall.run(), 0u);
+      for (int i = 0; i < 5; i++) {
+        const std::uint64_t parent = i > 0 ? brains[i - 1].hash() : 0;
+        QVERIFY(hall.add(brains[i], 10.0 * (i % 3), i, parent));
+      }
+      // already archived
+      QVERIFY(!hall.add(Brain(brains[2]), 100.0, 9));
+      QCOMPARE(hall.size(), std::size_t{5});
+    }
+
+    HallOfFame hall(path, arena.topology());
+    QCOMPARE(hall.size(), std::size_t{5});
+    QCOMPARE(hall.run(), 1u);
+    QCOMPARE(hall.entry(3).generation, 3u);
+    QCOMPARE(hall.entry(3).parent, brains[2].hash());
+
+    // scores 0 10 20 0 10
+    auto top = hall.top(3);
+    QCOMPARE(top, (std::vector<std::size_t>{2, 1, 4}));
+    QCOMPARE(hall.top(100).size(), std::size_t{5});
+
+    for (std::size_t i = 0; i < hall.size(); i++) {
+      auto brain = hall.brain(i, arena);
+      QCOMPARE(brain.hash(), brains[i].hash());
+      QCOMPARE(brain.hash(), brain.toNetwork().hash());
+      QVERIFY(std::equal(brain.parameters(),
+                         brain.parameters() + arena.parameterCount(),
+                         brains[i].parameters()));
+    }
+
+    Brain child(brains[0]);
+    child.mutate(1.0);
+    QVERIFY(hall.add(child, 30.0, 1, brains[0].hash()));
+    QCOMPARE(hall.top(1).front(), std::size_t{5});
+    QCOMPARE(hall.entry(5).run, 1u);
+    QCOMPARE(hall.brain(5, arena).hash(), child.hash());
+  }
+
+  void test_truncated_record_is_dropped() {
+    QTemporaryDir dir;
+    auto path = dir.filePath("hall_of_fame.bin").toStdString();
+    std::remove(path.c_str());
+
+    BrainArena arena(Topology{2, 3, 1});
+    {
+      HallOfFame hall(path, arena.topology());
+      hall.add(Brain(arena), 1.0, 0);
+      hall.add(Brain(arena), 2.0, 1);
+    }
+    // half a record, as left by a crash during an append
+    std::ofstream(path, std::ios::binary | std::ios::app) << "garbage";
+
+    HallOfFame hall(path, arena.topology());
+    QCOMPARE(hall.size(), std::size_t{2});
+    QVERIFY(hall.add(Brain(arena), 3.0, 2));
+    QCOMPARE(hall.entry(2).score, 3.0);
+  }
+
+  void test_other_files_are_rejected() {
+    QTemporaryDir dir;
+    auto path = dir.filePath("hall_of_fame.bin").toStdString();
+    std::remove(path.c_str());
+    {
+      HallOfFame hall(path, Topology{5, 8, 2});
+    }
+    QVERIFY_EXCEPTION_THROWN(HallOfFame(path, Topology{5, 6, 2}),
+                             std::runtime_error);
+
+    std::ofstream(path, std::ios::binary) << "hello world, not a hall of fame";
+    QVERIFY_EXCEPTION_THROWN(HallOfFame(path, Topology{5, 8, 2}),
+                             std::runtime_error);
+  }
+};
+QTEST_MAIN(testHallOfFame)
+#include "test_halloffame.moc"
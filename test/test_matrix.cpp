@@ -275,6 +275,56 @@ private slots:
 
     QVERIFY(n == m);
   }
+  void lazy_element_wise_chain() {
+    Matrix a(2, 3);
+    a.data = {{1, 2, 3}, {4, 5, 6}};
+    Matrix b(2, 3);
+    b.data = {{6, 5, 4}, {3, 2, 1}};
+
+    Matrix m = mx::map(mx::hadamard(a + b, a - b) * 2.0,
+                       [](double e) { return e + 1; });
+
+    Matrix exp(2, 3);
+    exp.data = {{-69, -41, -13}, {15, 43, 71}};
+    QVERIFY(m == exp);
+
+    QVERIFY_EXCEPTION_THROWN(a + Matrix(3, 2), std::runtime_error);
+  }
+
+  void lazy_transpose_and_product() {
+    Matrix a(2, 3);
+    a.data = {{1, 2, 3}, {4, 5, 6}};
+    Matrix b(2, 3);
+    b.data = {{7, 8, 9}, {10, 11, 12}};
+
+    Matrix t = mx::transpose(a);
+    QVERIFY(t == Matrix::transpose(a));
+
+    Matrix p = mx::product(a, mx::transpose(b));
+    QVERIFY(p == Matrix::multiply(a, Matrix::transpose(b)));
+
+    std::vector<double> v{1, 0, -1};
+    Matrix c = mx::product(a, mx::column(v));
+    QVERIFY(c == Matrix::multiply(a, Matrix::fromArray(v)));
+
+    QVERIFY_EXCEPTION_THROWN(mx::product(a, b), std::runtime_error);
+  }
+
+  void lazy_assignment() {
+    Matrix a(2, 2);
+    a.data = {{1, 2}, {3, 4}};
+    Matrix m(1, 1);
+
+    m = mx::transpose(a) * 10.0;
+    Matrix exp(2, 2);
+    exp.data = {{10, 30}, {20, 40}};
+    QVERIFY(m == exp);
+
+    m += a;
+    exp.data = {{11, 32}, {23, 44}};
+    QVERIFY(m == exp);
+  }
+
 #ifdef JSON_SERIALIZATION
   void test_serialization() {
 
@@ -0,0 +1,200 @@
+#include <QObject>
+#include <QTest>
+
+#include "boardgenerator.h"
+#include "minefield.h"
+
+#include <random>
+
+struct CountCell {
+  Position position;
+  bool mine{false};
+  int count{0};
+  explicit CountCell(Position position_p) : position(position_p) {}
+};
+
+class testMinefield : public QObject {
+
+  Q_OBJECT
+
+private slots:
+
+  void bit_plane() {
+    BitPlane plane(130);
+    QCOMPARE(plane.count(), std::size_t{0});
+    plane.set(0);
+    plane.set(64);
+    plane.set(129);
+    QVERIFY(plane.test(64) && !plane.test(63));
+    QCOMPARE(plane.count(), std::size_t{3});
+
+    plane.fill(true);
+    QCOMPARE(plane.count(), std::size_t{130});
+    plane.reset(5);
+    plane.flip(6);
+    QCOMPARE(plane.count(), std::size_t{128});
+
+    BitPlane other(130);
+    other.set(5);
+    plane |= other;
+    QCOMPARE(plane.count(), std::size_t{129});
+    plane.clear(other);
+    QCOMPARE(plane.count(), std::size_t{128});
+    plane &= other;
+    QVERIFY(!plane.any());
+
+    QVERIFY_EXCEPTION_THROWN(plane |= BitPlane(129), std::runtime_error);
+  }
+
+  void nibble_plane() {
+    NibblePlane plane(40);
+    for (std::size_t i = 0; i < plane.size(); i++) {
+      plane.set(i, static_cast<int>(i % 9));
+    }
+    for (std::size_t i = 0; i < plane.size(); i++) {
+      QCOMPARE(plane.get(i), static_cast<int>(i % 9));
+    }
+    plane.set(17, 15);
+    QCOMPARE(plane.get(16), 7);
+    QCOMPARE(plane.get(17), 15);
+    QCOMPARE(plane.get(18), 0);
+    plane.fill(3);
+    QCOMPARE(plane.get(39), 3);
+  }
+
+  void ten_million_cells_fit_in_a_few_megabytes() {
+    Minefield field(Size{2500, 4000});
+    QCOMPARE(field.cellCount(), std::size_t{10000000});
+    QVERIFY(field.planes().bytes() < 10 * 1024 * 1024);
+  }
+
+  void reveal_follows_the_rules() {
+    // mines on the last column, the rest of the board is revealed at once
+    Minefield field(Size{4, 5});
+    for (int row = 0; row < 4; row++) {
+      field.placeMine({4, row});
+    }
+    field.countNeighbors();
+    QCOMPARE(field.neighborMines({3, 0}), 2);
+    QCOMPARE(field.neighborMines({3, 1}), 3);
+    QCOMPARE(field.neighborMines({0, 0}), 0);
+
+    field.mark({2, 2});
+    QVERIFY(field.marked({2, 2}));
+    field.mark({2, 2});
+    QVERIFY(!field.marked({2, 2}));
+
+    QCOMPARE(field.reveal({0, 0}), std::size_t{16});
+    QCOMPARE(field.reveal({0, 0}), std::size_t{0});
+    QVERIFY(field.won());
+    QVERIFY(field.finished());
+  }
+
+  void revealing_a_mine_loses() {
+    Minefield field(Size{3, 3});
+    field.placeMine({0, 0});
+    field.placeMine({2, 2});
+    field.countNeighbors();
+    QCOMPARE(field.neighborMines({1, 1}), 2);
+
+    QCOMPARE(field.reveal({0, 2}), std::size_t{4});
+    QCOMPARE(field.reveal({1, 0}), std::size_t{1});
+    QVERIFY(!field.finished());
+    QCOMPARE(field.reveal({0, 0}), std::size_t{4});
+    QVERIFY(field.lost());
+    QVERIFY(!field.won());
+    QCOMPARE(field.revealedCount(), field.cellCount());
+  }
+
+  void neighbor_counts_match_per_cell_counts() {
+    ThreadPool pool(3);
+    std::mt19937 gen(7);
+    std::bernoulli_distribution mine(0.3);
+
+    for (Size size : {Size{1, 1}, Size{1, 40}, Size{40, 1}, Size{2, 3},
+                      Size{17, 33}, Size{100, 257}}) {
+      // the per cell counting of minesweeper.cpp
+      Grid<CountCell> grid(size);
+      Minefield field(size);
+      grid.forEach([&](CountCell &cell) {
+        cell.mine = mine(gen);
+        if (cell.mine) {
+          field.placeMine(cell.position);
+        }
+      });
+      grid.forEach([&grid](CountCell &cell) {
+        grid.forEachNeighbor(cell, [&cell](CountCell &neighbor) {
+          cell.count += neighbor.mine;
+        });
+      });
+
+      for (ThreadPool *p : {static_cast<ThreadPool *>(nullptr), &pool}) {
+        field.countNeighbors(p);
+        grid.forEach([&field](const CountCell &cell) {
+          QCOMPARE(field.neighborMines(cell.position), cell.count);
+        });
+      }
+    }
+  }
+
+  void generated_boards_are_seeded() {
+    auto a = board::generate(Size{30, 40}, 300, 11);
+    auto b = board::generate(Size{30, 40}, 300, 11);
+    auto c = board::generate(Size{30, 40}, 300, 12);
+    QCOMPARE(a.mineCount(), std::size_t{300});
+    QVERIFY(a.planes().flags(Minefield::Mine).words() ==
+            b.planes().flags(Minefield::Mine).words());
+    QVERIFY(a.planes().flags(Minefield::Mine).words() !=
+            c.planes().flags(Minefield::Mine).words());
+
+    // dense boards are as fast as sparse ones
+    QCOMPARE(board::generate(Size{30, 40}, 1199, 3).mineCount(),
+             std::size_t{1199});
+    QVERIFY_EXCEPTION_THROWN(board::generate(Size{30, 40}, 1201, 3),
+                             std::runtime_error);
+  }
+
+  void first_click_is_safe() {
+    for (std::uint64_t seed = 0; seed < 50; seed++) {
+      auto field = board::generate(Size{9, 9}, 72, seed, Position{4, 0});
+      QCOMPARE(field.mineCount(), std::size_t{72});
+      QVERIFY(!field.mine({4, 0}));
+      QCOMPARE(field.neighborMines({4, 0}), 0);
+      QVERIFY(field.reveal({4, 0}) > 1);
+    }
+    // no room for the neighbors, the first click alone is safe
+    auto field = board::generate(Size{3, 3}, 8, 1, Position{1, 1});
+    QVERIFY(!field.mine({1, 1}));
+    QCOMPARE(field.mineCount(), std::size_t{8});
+  }
+
+  void mines_are_uniform() {
+    // each cell of a 3x3 board with 2 mines is a mine 2 times out of 9
+    std::vector<int> hits(9, 0);
+    const int boards = 9000;
+    for (int seed = 0; seed < boards; seed++) {
+      auto field = board::generate(Size{3, 3}, 2, seed);
+      for (std::size_t id = 0; id < 9; id++) {
+        hits[id] += field.planes().flags(Minefield::Mine).test(id);
+      }
+    }
+    for (int h : hits) {
+      QVERIFY(std::abs(h - 2000) < 150);
+    }
+  }
+
+  void large_boards_are_generated_in_parallel() {
+    // 3 chunks, same board with or without a pool
+    ThreadPool pool(3);
+    const Size size{1500, 1500};
+    auto serial = board::generate(size, 450000, 5, Position{700, 700});
+    auto parallel =
+        board::generate(size, 450000, 5, Position{700, 700}, &pool);
+    QCOMPARE(serial.mineCount(), std::size_t{450000});
+    QVERIFY(serial.planes().flags(Minefield::Mine).words() ==
+            parallel.planes().flags(Minefield::Mine).words());
+    QVERIFY(!serial.mine({700, 700}) && !serial.mine({701, 701}));
+  }
+};
+QTEST_MAIN(testMinefield)
+#include "test_minefield.moc"
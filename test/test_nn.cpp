@@ -1,5 +1,6 @@
 #include "neuralnetwork/nn.h"
 #include <QObject>
+#include <QTemporaryDir>
 #include <QTest>
 #include <iostream>
 
@@ -29,8 +30,48 @@ private slots:
 
     QVERIFY(nn == mm);
   }
+
+  void test_streaming_load() {
+    NeuralNetwork nn(4, 8, 2);
+    nn.setLearningRate(0.25);
+
+    QTemporaryDir dir;
+    for (bool compact : {false, true}) {
+      auto path = dir.filePath("brain.json").toStdString();
+      nn.save(path, compact);
+
+      NeuralNetwork mm(4, 8, 2);
+      mm.load(path);
+      QVERIFY(nn == mm);
+      QCOMPARE(mm.serialise(), nn.serialise());
+      QVERIFY(NeuralNetwork::Load(path) == mm);
+    }
+
+    auto path = dir.filePath("brain.json").toStdString();
+    NeuralNetwork other(4, 6, 2);
+    QVERIFY_EXCEPTION_THROWN(other.load(path), std::runtime_error);
+
+    auto text = nn.serialise(-1);
+    std::ofstream(path) << text.substr(0, text.size() / 2);
+    NeuralNetwork mm(4, 8, 2);
+    QVERIFY_EXCEPTION_THROWN(mm.load(path), std::runtime_error);
+  }
 #endif
 
+  void test_parameters() {
+    NeuralNetwork nn(4, 8, 2);
+    auto params = nn.parameters();
+    QCOMPARE(params.size(), nn.parameterCount());
+    QCOMPARE(params.size(), std::size_t(8 * 5 + 2 * 9));
+
+    NeuralNetwork mm(4, 8, 2);
+    mm.setParameters(params);
+    QVERIFY(nn == mm);
+
+    params.pop_back();
+    QVERIFY_EXCEPTION_THROWN(mm.setParameters(params), std::runtime_error);
+  }
+
   void test_xor_ai() {
 
     struct TrainingData {
@@ -0,0 +1,139 @@
+#include <QObject>
+#include <QTest>
+
+#include "bird.h"
+#include "physics.h"
+
+#include <random>
+
+const int ScreenHeight = 480;
+
+struct Scenario {
+  std::vector<Bird> birds;
+  std::vector<Pipe> pipes; // closest pipe of each bird
+  std::vector<bool> flaps;
+};
+
+Course course{7};
+
+// birds and pipes around the collision and offscreen boundaries
+Scenario randomScenario(std::size_t count, bool shared_pipe) {
+  std::mt19937 gen(count);
+  std::uniform_int_distribution<int> y(-20, ScreenHeight + 20);
+  std::uniform_int_distribution<int> velocity(-12, 12);
+  std::uniform_int_distribution<int> pipe_x(-60, 60);
+  std::bernoulli_distribution flap(0.3);
+
+  Scenario s;
+  Pipe pipe(0, ScreenHeight, 50, course);
+  for (std::size_t i = 0; i < count; i++) {
+    Bird bird(20 + (i % 3) * 10, y(gen));
+    bird.velocity = velocity(gen);
+    bird.score = static_cast<int>(i);
+    s.birds.push_back(bird);
+
+    if (!shared_pipe || i == 0) {
+      pipe = Pipe(pipe_x(gen), ScreenHeight, 50, course);
+    }
+    s.pipes.push_back(pipe);
+    s.flaps.push_back(flap(gen));
+  }
+  return s;
+}
+
+// rules of the game, one bird at a time
+std::vector<std::uint8_t> reference(Scenario &s) {
+  std::vector<std::uint8_t> dead;
+  for (std::size_t i = 0; i < s.birds.size(); i++) {
+    auto &bird = s.birds[i];
+    if (s.flaps[i]) {
+      bird.up();
+    }
+    bird.update();
+    dead.push_back(bird.offscreen(ScreenHeight) || bird.hits(s.pipes[i]));
+  }
+  return dead;
+}
+
+void toLanes(const Scenario &s, bool shared_pipe, BirdLanes &lanes,
+             PipeLanes &pipes) {
+  lanes.resize(s.birds.size());
+  for (std::size_t i = 0; i < s.birds.size(); i++) {
+    lanes.x[i] = s.birds[i].x;
+    lanes.y[i] = s.birds[i].y;
+    lanes.velocity[i] = s.birds[i].velocity;
+    lanes.score[i] = s.birds[i].score;
+    lanes.flap[i] = s.flaps[i];
+    if (!shared_pipe || i == 0) {
+      pipes.x.push_back(s.pipes[i].x);
+      pipes.top.push_back(s.pipes[i].top);
+    }
+  }
+  pipes.width = s.pipes[0].width;
+  pipes.gate = s.pipes[0].gate;
+}
+
+class testPhysics : public QObject {
+
+  Q_OBJECT
+
+  using Kernel = void (*)(BirdLanes &, const PhysicsRules &,
+                          const PipeLanes &);
+
+  void compare(Kernel kernel) {
+    PhysicsRules rules;
+    rules.screen_height = ScreenHeight;
+
+    for (bool shared : {true, false}) {
+      for (std::size_t count : {1, 7, 8, 9, 300, 1001}) {
+        auto s = randomScenario(count, shared);
+        BirdLanes lanes;
+        PipeLanes pipes;
+        toLanes(s, shared, lanes, pipes);
+
+        kernel(lanes, rules, pipes);
+        auto dead = reference(s);
+
+        QVERIFY(lanes.dead == dead);
+        for (std::size_t i = 0; i < count; i++) {
+          QCOMPARE(lanes.y[i], s.birds[i].y);
+          QCOMPARE(lanes.velocity[i], s.birds[i].velocity);
+          QCOMPARE(lanes.score[i], s.birds[i].score);
+        }
+      }
+    }
+  }
+
+private slots:
+
+  void scalar_kernel_follows_bird_rules() {
+    compare([](BirdLanes &b, const PhysicsRules &r, const PipeLanes &p) {
+      physics::stepScalar(b, r, p, 0, b.size());
+    });
+  }
+
+  void avx2_kernel_follows_bird_rules() {
+#ifdef PHYSICS_X86
+    if (!physics::hasAvx2()) {
+      QSKIP("no avx2 on this cpu");
+    }
+    compare([](BirdLanes &b, const PhysicsRules &r, const PipeLanes &p) {
+      auto done = physics::stepAvx2(b, r, p);
+      physics::stepScalar(b, r, p, done, b.size());
+    });
+#else
+    QSKIP("not a x86 cpu");
+#endif
+  }
+
+  void dispatched_kernel_follows_bird_rules() { compare(stepBirds); }
+
+  void both_kinds_of_death_are_detected() {
+    auto s = randomScenario(1001, false);
+    auto dead = reference(s);
+    auto deaths = std::count(dead.begin(), dead.end(), 1);
+    QVERIFY(deaths > 0 && deaths < 1001);
+  }
+};
+QTEST_MAIN(testPhysics)
+#include "test_physics.moc"
@@ -0,0 +1,139 @@
+#include <QObject>
+#include <QTest>
+
+#include "p5/displaylist.h"
+#include "p5/qtcanvas.h"
+#include "p5/threadpool.h"
+
+#include <QEvent>
+
+#include <memory>
+
+// fills the whole canvas with color at each frame, the canvas clips it
+struct FillApplication : IApplication {
+  QColor color{255, 0, 0};
+  int draws{0};
+  bool full{false};
+
+  void draw(Canvas &canvas) override {
+    draws++;
+    full = canvas.fullRedraw();
+    canvas.noStroke();
+    canvas.fill(color.red(), color.green(), color.blue());
+    canvas.rect(0, 0, canvas.width(), canvas.height());
+  }
+  void mousePressed(Canvas &) override {}
+  void keyPressed(Canvas &) override {}
+};
+
+// counts the paint events of the watched widget
+struct PaintCounter : QObject {
+  int paints{0};
+
+  bool eventFilter(QObject *, QEvent *event) override {
+    paints += event->type() == QEvent::Paint;
+    return false;
+  }
+};
+
+// a whole canvas rect of color, recorded off the GUI thread
+std::shared_ptr<const DisplayList> filled(int r, int g, int b) {
+  RecordingCanvas recording(100, 80);
+  recording.noStroke();
+  recording.fill(r, g, b);
+  recording.rect(0, 0, 100, 80);
+  return std::make_shared<const DisplayList>(recording.take());
+}
+
+class testQtCanvas : public QObject {
+
+  Q_OBJECT
+
+private slots:
+
+  void partial_repaint_draws_dirty_areas_only() {
+    FillApplication app;
+    QtCanvas canvas(&app);
+    canvas.setSize(100, 80);
+    canvas.partialRepaint(true);
+    canvas.show();
+    QVERIFY(QTest::qWaitForWindowExposed(&canvas));
+
+    // the first frame paints everything
+    QTRY_VERIFY(app.draws >= 1);
+    QVERIFY(app.full);
+    const int draws = app.draws;
+    QImage image = canvas.grab().toImage();
+    QCOMPARE(image.pixelColor(5, 5), QColor(255, 0, 0));
+    QCOMPARE(image.pixelColor(95, 75), QColor(255, 0, 0));
+
+    // a tick without redraw() does not draw
+    canvas.refresh();
+    QTest::qWait(50);
+    QCOMPARE(app.draws, draws);
+
+    // redraw(rect) repaints inside rect only
+    app.color = QColor(0, 0, 255);
+    canvas.redraw(Rect{10, 20, 30, 15});
+    canvas.refresh();
+    QTRY_COMPARE(app.draws, draws + 1);
+    QVERIFY(!app.full);
+
+    image = canvas.grab().toImage();
+    QCOMPARE(app.draws, draws + 1);
+    QCOMPARE(image.pixelColor(10, 20), QColor(0, 0, 255));
+    QCOMPARE(image.pixelColor(39, 34), QColor(0, 0, 255));
+    QCOMPARE(image.pixelColor(9, 20), QColor(255, 0, 0));
+    QCOMPARE(image.pixelColor(40, 34), QColor(255, 0, 0));
+    QCOMPARE(image.pixelColor(39, 35), QColor(255, 0, 0));
+    QCOMPARE(image.pixelColor(95, 75), QColor(255, 0, 0));
+  }
+
+  void posted_lists_replace_draw() {
+    FillApplication app;
+    QtCanvas canvas(&app);
+    canvas.setSize(100, 80);
+    canvas.show();
+    QVERIFY(QTest::qWaitForWindowExposed(&canvas));
+    QTRY_VERIFY(app.draws >= 1);
+
+    ThreadPool pool(1);
+    pool.parallelFor(1, [&canvas](std::size_t, std::size_t) {
+      canvas.post(filled(0, 255, 0));
+    });
+    canvas.refresh();
+    QImage image = canvas.grab().toImage();
+    QCOMPARE(image.pixelColor(5, 5), QColor(0, 255, 0));
+    QCOMPARE(image.pixelColor(95, 75), QColor(0, 255, 0));
+
+    // an equal list leaves the widget as it is
+    QTest::qWait(50);
+    PaintCounter counter;
+    canvas.installEventFilter(&counter);
+    pool.parallelFor(1, [&canvas](std::size_t, std::size_t) {
+      canvas.post(filled(0, 255, 0));
+    });
+    canvas.refresh();
+    QTest::qWait(50);
+    QCOMPARE(counter.paints, 0);
+
+    // nullptr goes back to the application draw()
+    const int draws = app.draws;
+    canvas.post(nullptr);
+    canvas.refresh();
+    QTRY_VERIFY(counter.paints >= 1);
+    image = canvas.grab().toImage();
+    QVERIFY(app.draws > draws);
+    QCOMPARE(image.pixelColor(5, 5), QColor(255, 0, 0));
+    canvas.removeEventFilter(&counter);
+  }
+};
+
+// the widget is shown on the offscreen platform, no display is needed
+int main(int argc, char *argv[]) {
+  qputenv("QT_QPA_PLATFORM", "offscreen");
+  QApplication application(argc, argv);
+  testQtCanvas test;
+  return QTest::qExec(&test, argc, argv);
+}
+#include "test_qtcanvas.moc"
@@ -0,0 +1,47 @@
+#include <QObject>
+#include <QTest>
+
+#include "solver.h"
+
+class testSolver : public QObject {
+
+  Q_OBJECT
+
+private slots:
+
+  void solves_a_board_without_guessing() {
+    // the mine in the corner follows from the 1s around it
+    Minefield field(Size{4, 4});
+    field.placeMine({3, 3});
+    field.countNeighbors();
+    const auto result = solver::Solver(field, 1).play({0, 0});
+    QVERIFY(result.won);
+    QCOMPARE(result.guesses, 0);
+  }
+
+  void marks_only_mines() {
+    for (std::uint64_t seed = 0; seed < 200; seed++) {
+      auto field = board::generate(Size{16, 16}, 40, seed, Position{8, 8});
+      solver::Solver(field, seed).play({8, 8});
+      BitPlane wrong = field.planes().flags(Minefield::Marked);
+      wrong.clear(field.planes().flags(Minefield::Mine));
+      QVERIFY(!wrong.any());
+    }
+  }
+
+  void results_do_not_depend_on_the_pool() {
+    ThreadPool pool(3);
+    const auto serial = solver::playBoards(Size{16, 16}, 40, 300, 7);
+    const auto parallel = solver::playBoards(Size{16, 16}, 40, 300, 7, &pool);
+    QCOMPARE(serial.boards, std::size_t{300});
+    QCOMPARE(serial.wins, parallel.wins);
+    QCOMPARE(serial.guesses, parallel.guesses);
+  }
+
+  void wins_most_beginner_boards() {
+    const auto stats = solver::playBoards(Size{9, 9}, 10, 500, 3);
+    QVERIFY(stats.winRate() > 0.85);
+  }
+};
+QTEST_MAIN(testSolver)
+#include "test_solver.moc"
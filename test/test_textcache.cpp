@@ -0,0 +1,54 @@
+#include <QObject>
+#include <QTest>
+
+#include "p5/textcache.h"
+
+class testTextCache : public QObject {
+
+  Q_OBJECT
+
+private slots:
+
+  void strings_are_laid_out_once() {
+    TextCache cache;
+    const QFont font;
+    for (int frame = 0; frame < 10; frame++) {
+      for (int n = 1; n <= 8; n++) {
+        cache.get(std::to_string(n), font);
+      }
+    }
+    QCOMPARE(cache.size(), std::size_t{8});
+    QCOMPARE(cache.misses(), std::uint64_t{8});
+    QCOMPARE(cache.hits(), std::uint64_t{72});
+    QCOMPARE(cache.hitRate(), 0.9);
+  }
+
+  void fonts_are_part_of_the_key() {
+    TextCache cache;
+    QFont big;
+    big.setPointSize(40);
+    cache.get("1", QFont{});
+    cache.get("1", big);
+    cache.get("1", big);
+    QCOMPARE(cache.size(), std::size_t{2});
+    QCOMPARE(cache.misses(), std::uint64_t{2});
+    QVERIFY(cache.get("1", big).ascent > cache.get("1", QFont{}).ascent);
+  }
+
+  void least_recently_drawn_is_dropped() {
+    TextCache cache(2);
+    const QFont font;
+    cache.get("a", font);
+    cache.get("b", font);
+    cache.get("a", font); // b is now the oldest
+    cache.get("c", font);
+    QCOMPARE(cache.size(), std::size_t{2});
+
+    cache.get("a", font);
+    QCOMPARE(cache.misses(), std::uint64_t{3});
+    cache.get("b", font);
+    QCOMPARE(cache.misses(), std::uint64_t{4});
+  }
+};
+QTEST_MAIN(testTextCache)
+#include "test_textcache.moc"
@@ -0,0 +1,136 @@
+#include <QObject>
+#include <QTest>
+
+#include "bird.h"
+#include "vectorenv.h"
+
+#include <list>
+
+// flap when close to the bottom of the gate, dies on some courses only
+bool policy(const double *obs) { return obs[0] > obs[3] - 0.05; }
+
+// one world, the flappy_bird way, with Bird and Pipe
+int reference(std::uint32_t seed, const VectorEnv::Config &config) {
+  Course course{seed};
+  std::list<Pipe> pipes;
+  pipes.emplace_back(config.width, config.height, config.pipe_width, course);
+  int pipe_creator_counter = 0;
+  Bird bird(config.bird_x, config.height / 2);
+
+  for (;;) {
+    for (auto &pipe : pipes) {
+      pipe.update(config.velocity);
+    }
+    auto &closest = *std::find_if(
+        pipes.begin(), pipes.end(), [&config](const Pipe &pipe) {
+          return pipe.x + pipe.width > config.bird_x;
+        });
+
+    double obs[VectorEnv::ObservationSize] = {
+        bird.y / double(config.height), closest.x / double(config.width),
+        closest.top / double(config.height),
+        (closest.top + closest.gate) / double(config.height),
+        bird.velocity / 10.0};
+    if (policy(obs)) {
+      bird.up();
+    }
+    bird.update();
+    if (bird.offscreen(config.height) || bird.hits(closest) ||
+        bird.score >= config.max_score) {
+      return bird.score;
+    }
+
+    pipes.remove_if([](const Pipe &pipe) { return pipe.offscreen(); });
+    pipe_creator_counter++;
+    if (pipe_creator_counter > config.pipe_creation) {
+      pipe_creator_counter = 0;
+      pipes.emplace_back(config.width, config.height, config.pipe_width,
+                         course);
+    }
+  }
+}
+
+std::vector<int> run(VectorEnv &env, const std::vector<std::uint32_t> &seeds) {
+  env.reset(seeds);
+  std::vector<std::uint8_t> actions(env.size());
+  while (!env.allDone()) {
+    for (std::size_t i = 0; i < env.size(); i++) {
+      actions[i] = policy(env.observation(i));
+    }
+    env.step(actions);
+  }
+
+  std::vector<int> scores;
+  for (std::size_t i = 0; i < env.size(); i++) {
+    scores.push_back(env.score(i));
+  }
+  return scores;
+}
+
+VectorEnv::Config limited() {
+  VectorEnv::Config config;
+  config.max_score = 5000;
+  return config;
+}
+
+class testVectorEnv : public QObject {
+
+  Q_OBJECT
+
+private slots:
+
+  void worlds_follow_the_game_rules() {
+    std::vector<std::uint32_t> seeds;
+    for (std::uint32_t s = 0; s < 37; s++) {
+      seeds.push_back(s * 7919);
+    }
+    VectorEnv env(seeds.size(), limited());
+    auto scores = run(env, seeds);
+
+    for (std::size_t i = 0; i < seeds.size(); i++) {
+      QCOMPARE(scores[i], reference(seeds[i], env.config()));
+    }
+  }
+
+  void worlds_are_independent() {
+    VectorEnv one(1, limited());
+    VectorEnv many(16, limited());
+    std::vector<std::uint32_t> seeds;
+    for (std::uint32_t s = 0; s < 16; s++) {
+      seeds.push_back(1000 + s);
+    }
+    auto scores = run(many, seeds);
+
+    for (std::size_t i = 0; i < seeds.size(); i++) {
+      QCOMPARE(run(one, {seeds[i]})[0], scores[i]);
+    }
+  }
+
+  void policy_survives_several_pipes() {
+    VectorEnv env(8, limited());
+    auto scores = run(env, {1, 2, 3, 4, 5, 6, 7, 8});
+    QVERIFY(*std::max_element(scores.begin(), scores.end()) > 300);
+
+    long ticks = 0;
+    for (int score : scores) {
+      ticks += score;
+    }
+    QCOMPARE(env.ticks(), ticks);
+  }
+
+  void doing_nothing_falls_offscreen() {
+    VectorEnv env(3);
+    env.reset({1, 2, 3});
+    std::vector<std::uint8_t> nothing(3, 0);
+    int ticks = 0;
+    while (!env.allDone()) {
+      env.step(nothing);
+      ticks++;
+    }
+    // y = 240 + t(t+1)/2 goes past 470 after 21 ticks
+    QCOMPARE(ticks, 21);
+    QCOMPARE(env.score(0), 21);
+  }
+};
+QTEST_MAIN(testVectorEnv)
+#include "test_vectorenv.moc"